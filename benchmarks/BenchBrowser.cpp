@@ -0,0 +1,109 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/browser.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/record.h>
+
+#include "common/testserver.h"
+
+const QByteArray Type = "_test._tcp.local.";
+
+class BenchBrowser : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void benchBrowser_data();
+    void benchBrowser();
+};
+
+void BenchBrowser::benchBrowser_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("10") << 10;
+    QTest::newRow("100") << 100;
+    QTest::newRow("1000") << 1000;
+}
+
+void BenchBrowser::benchBrowser()
+{
+    QFETCH(int, count);
+
+    // Each service is announced by its own host in a separate message
+    QList<QMdnsEngine::Message> messages;
+    for (int i = 0; i < count; ++i) {
+        const QByteArray fqName = "Service " + QByteArray::number(i) + "." + Type;
+        const QByteArray target = "host" + QByteArray::number(i) + ".local.";
+        QMdnsEngine::Message message;
+        message.setResponse(true);
+        QMdnsEngine::Record ptrRecord;
+        ptrRecord.setName(Type);
+        ptrRecord.setType(QMdnsEngine::PTR);
+        ptrRecord.setTarget(fqName);
+        message.addRecord(ptrRecord);
+        QMdnsEngine::Record srvRecord;
+        srvRecord.setName(fqName);
+        srvRecord.setType(QMdnsEngine::SRV);
+        srvRecord.setFlushCache(true);
+        srvRecord.setPort(1234);
+        srvRecord.setTarget(target);
+        message.addRecord(srvRecord);
+        QMdnsEngine::Record txtRecord;
+        txtRecord.setName(fqName);
+        txtRecord.setType(QMdnsEngine::TXT);
+        txtRecord.setFlushCache(true);
+        txtRecord.addAttribute("id", QByteArray::number(i));
+        message.addRecord(txtRecord);
+        QMdnsEngine::Record aRecord;
+        aRecord.setName(target);
+        aRecord.setType(QMdnsEngine::A);
+        aRecord.setFlushCache(true);
+        aRecord.setAddress(QHostAddress(static_cast<quint32>(0x0a000000 + i)));
+        message.addRecord(aRecord);
+        messages.append(message);
+    }
+
+    QBENCHMARK {
+        TestServer server;
+        QMdnsEngine::Browser browser(&server, Type);
+        int added = 0;
+        connect(&browser, &QMdnsEngine::Browser::serviceAdded, [&added]() {
+            ++added;
+        });
+        for (const QMdnsEngine::Message &message : messages) {
+            server.deliverMessage(message);
+        }
+        QCOMPARE(added, count);
+    }
+}
+
+QTEST_MAIN(BenchBrowser)
+#include "BenchBrowser.moc"
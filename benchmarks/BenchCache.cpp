@@ -0,0 +1,222 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/cache.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/record.h>
+
+const int LookupCount = 1000;
+
+// Application that measures the time spent handling timer events; the cache
+// does its work in response to its timer, so this is the time spent
+// processing refresh and expiry triggers without the time spent waiting
+class TimingApplication : public QCoreApplication
+{
+public:
+
+    TimingApplication(int &argc, char **argv) : QCoreApplication(argc, argv), mTimerNsecs(0) {}
+
+    virtual bool notify(QObject *receiver, QEvent *event)
+    {
+        if (event->type() != QEvent::Timer) {
+            return QCoreApplication::notify(receiver, event);
+        }
+        QElapsedTimer timer;
+        timer.start();
+        bool result = QCoreApplication::notify(receiver, event);
+        mTimerNsecs += timer.nsecsElapsed();
+        return result;
+    }
+
+    qint64 timerNsecs() const { return mTimerNsecs; }
+    void resetTimerNsecs() { mTimerNsecs = 0; }
+
+private:
+
+    qint64 mTimerNsecs;
+};
+
+class BenchCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void benchAddRecord_data();
+    void benchAddRecord();
+
+    void benchLookupRecords_data();
+    void benchLookupRecords();
+
+    void benchLookupRecordsAny_data();
+    void benchLookupRecordsAny();
+
+    void benchTriggers_data();
+    void benchTriggers();
+
+private:
+
+    void createData();
+
+    QList<QMdnsEngine::Record> createRecords(int count, quint32 ttl = 3600) const;
+};
+
+void BenchCache::benchAddRecord_data()
+{
+    createData();
+}
+
+void BenchCache::benchAddRecord()
+{
+    QFETCH(int, count);
+
+    const QList<QMdnsEngine::Record> records = createRecords(count);
+
+    QBENCHMARK {
+        QMdnsEngine::Cache cache;
+        for (const QMdnsEngine::Record &record : records) {
+            cache.addRecord(record);
+        }
+    }
+}
+
+void BenchCache::benchLookupRecords_data()
+{
+    createData();
+}
+
+void BenchCache::benchLookupRecords()
+{
+    QFETCH(int, count);
+
+    const QList<QMdnsEngine::Record> records = createRecords(count);
+    QMdnsEngine::Cache cache;
+    for (const QMdnsEngine::Record &record : records) {
+        cache.addRecord(record);
+    }
+
+    // Look up an equal number of records regardless of the size of the cache
+    QBENCHMARK {
+        for (int i = 0; i < LookupCount; ++i) {
+            const QMdnsEngine::Record &record = records.at(i * (count / LookupCount));
+            QList<QMdnsEngine::Record> lookupRecords;
+            cache.lookupRecords(record.name(), record.type(), lookupRecords);
+        }
+    }
+}
+
+void BenchCache::benchLookupRecordsAny_data()
+{
+    createData();
+}
+
+void BenchCache::benchLookupRecordsAny()
+{
+    QFETCH(int, count);
+
+    const QList<QMdnsEngine::Record> records = createRecords(count);
+    QMdnsEngine::Cache cache;
+    for (const QMdnsEngine::Record &record : records) {
+        cache.addRecord(record);
+    }
+
+    QBENCHMARK {
+        for (int i = 0; i < LookupCount; ++i) {
+            const QMdnsEngine::Record &record = records.at(i * (count / LookupCount));
+            QList<QMdnsEngine::Record> lookupRecords;
+            cache.lookupRecords(record.name(), QMdnsEngine::ANY, lookupRecords);
+        }
+    }
+}
+
+void BenchCache::benchTriggers_data()
+{
+    createData();
+}
+
+void BenchCache::benchTriggers()
+{
+    QFETCH(int, count);
+
+    TimingApplication *app = static_cast<TimingApplication*>(QCoreApplication::instance());
+    const QList<QMdnsEngine::Record> records = createRecords(count, 1);
+    QMdnsEngine::Cache cache;
+    int expired = 0;
+    connect(&cache, &QMdnsEngine::Cache::recordExpired, [&expired]() {
+        ++expired;
+    });
+
+    // Every record goes through all of its refresh triggers before expiring;
+    // only the time spent handling the triggers is reported
+    for (const QMdnsEngine::Record &record : records) {
+        cache.addRecord(record);
+    }
+    app->resetTimerNsecs();
+    QTRY_COMPARE_WITH_TIMEOUT(expired, count, 10000);
+    QTest::setBenchmarkResult(app->timerNsecs() / 1000000.0, QTest::WalltimeMilliseconds);
+}
+
+void BenchCache::createData()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+}
+
+QList<QMdnsEngine::Record> BenchCache::createRecords(int count, quint32 ttl) const
+{
+    // Each host has an A and AAAA record
+    QList<QMdnsEngine::Record> records;
+    for (int i = 0; i < count; ++i) {
+        QMdnsEngine::Record record;
+        record.setName("host" + QByteArray::number(i / 2) + ".local.");
+        record.setTtl(ttl);
+        if (i % 2) {
+            record.setType(QMdnsEngine::AAAA);
+            record.setAddress(QHostAddress(QString("fe80::%1").arg(i, 0, 16)));
+        } else {
+            record.setType(QMdnsEngine::A);
+            record.setAddress(QHostAddress(static_cast<quint32>(0x0a000000 + i)));
+        }
+        records.append(record);
+    }
+    return records;
+}
+
+int main(int argc, char *argv[])
+{
+    TimingApplication app(argc, argv);
+    BenchCache bench;
+    return QTest::qExec(&bench, argc, argv);
+}
+
+#include "BenchCache.moc"
@@ -0,0 +1,238 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/bitmap.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/messageview.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+Q_DECLARE_METATYPE(QMdnsEngine::Message)
+
+const QByteArray Type = "_http._tcp.local.";
+const QByteArray Target = "host.local.";
+const int ServiceCount = 50;
+
+class BenchDns : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void initTestCase();
+
+    void benchToPacket_data();
+    void benchToPacket();
+
+    void benchFromPacket_data();
+    void benchFromPacket();
+
+    void benchMessageView_data();
+    void benchMessageView();
+
+private:
+
+    void createData();
+
+    QMdnsEngine::Message queryMessage() const;
+    QMdnsEngine::Message announcementMessage() const;
+    QMdnsEngine::Message browseMessage() const;
+};
+
+void BenchDns::initTestCase()
+{
+    qRegisterMetaType<QMdnsEngine::Message>("Message");
+}
+
+void BenchDns::benchToPacket_data()
+{
+    createData();
+}
+
+void BenchDns::benchToPacket()
+{
+    QFETCH(QMdnsEngine::Message, message);
+
+    QBENCHMARK {
+        QByteArray packet;
+        QMdnsEngine::toPacket(message, packet);
+    }
+}
+
+void BenchDns::benchFromPacket_data()
+{
+    createData();
+}
+
+void BenchDns::benchFromPacket()
+{
+    QFETCH(QMdnsEngine::Message, message);
+
+    QByteArray packet;
+    QMdnsEngine::toPacket(message, packet);
+
+    QBENCHMARK {
+        QMdnsEngine::Message parsedMessage;
+        QVERIFY(QMdnsEngine::fromPacket(packet, parsedMessage));
+    }
+}
+
+void BenchDns::benchMessageView_data()
+{
+    createData();
+}
+
+void BenchDns::benchMessageView()
+{
+    QFETCH(QMdnsEngine::Message, message);
+
+    QByteArray packet;
+    QMdnsEngine::toPacket(message, packet);
+
+    QBENCHMARK {
+        QMdnsEngine::MessageView view;
+        QVERIFY(view.parse(packet));
+    }
+}
+
+void BenchDns::createData()
+{
+    QTest::addColumn<QMdnsEngine::Message>("message");
+
+    QTest::newRow("query") << queryMessage();
+    QTest::newRow("announcement") << announcementMessage();
+    QTest::newRow("browse") << browseMessage();
+}
+
+QMdnsEngine::Message BenchDns::queryMessage() const
+{
+    // A browse query carrying the services that are already known
+    QMdnsEngine::Message message;
+    QMdnsEngine::Query query;
+    query.setName(Type);
+    query.setType(QMdnsEngine::PTR);
+    message.addQuery(query);
+    for (int i = 0; i < 10; ++i) {
+        QMdnsEngine::Record record;
+        record.setName(Type);
+        record.setType(QMdnsEngine::PTR);
+        record.setTarget("Service " + QByteArray::number(i) + "." + Type);
+        message.addRecord(record);
+    }
+    return message;
+}
+
+QMdnsEngine::Message BenchDns::announcementMessage() const
+{
+    // The records announced by a host providing a single service
+    const QByteArray fqName = "Service." + Type;
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    QMdnsEngine::Record ptrRecord;
+    ptrRecord.setName(Type);
+    ptrRecord.setType(QMdnsEngine::PTR);
+    ptrRecord.setTarget(fqName);
+    message.addRecord(ptrRecord);
+    QMdnsEngine::Record srvRecord;
+    srvRecord.setName(fqName);
+    srvRecord.setType(QMdnsEngine::SRV);
+    srvRecord.setFlushCache(true);
+    srvRecord.setPort(80);
+    srvRecord.setTarget(Target);
+    message.addRecord(srvRecord);
+    QMdnsEngine::Record txtRecord;
+    txtRecord.setName(fqName);
+    txtRecord.setType(QMdnsEngine::TXT);
+    txtRecord.setFlushCache(true);
+    txtRecord.setAttributes({
+        {"txtvers", "1"},
+        {"path", "/index.html"},
+        {"version", "1.2.3"},
+        {"model", "Example"},
+        {"secure", QByteArray()}
+    });
+    message.addRecord(txtRecord);
+    QMdnsEngine::Record aRecord;
+    aRecord.setName(Target);
+    aRecord.setType(QMdnsEngine::A);
+    aRecord.setFlushCache(true);
+    aRecord.setAddress(QHostAddress("192.168.1.10"));
+    message.addRecord(aRecord);
+    QMdnsEngine::Record aaaaRecord;
+    aaaaRecord.setName(Target);
+    aaaaRecord.setType(QMdnsEngine::AAAA);
+    aaaaRecord.setFlushCache(true);
+    aaaaRecord.setAddress(QHostAddress("fe80::1"));
+    message.addRecord(aaaaRecord);
+    QMdnsEngine::Record nsecRecord;
+    nsecRecord.setName(Target);
+    nsecRecord.setType(QMdnsEngine::NSEC);
+    nsecRecord.setFlushCache(true);
+    nsecRecord.setNextDomainName(Target);
+    const quint8 bitmapData[] = {0x40, 0x00, 0x00, 0x08};
+    QMdnsEngine::Bitmap bitmap;
+    bitmap.setData(sizeof(bitmapData), bitmapData);
+    nsecRecord.setBitmap(bitmap);
+    message.addRecord(nsecRecord);
+    return message;
+}
+
+QMdnsEngine::Message BenchDns::browseMessage() const
+{
+    // A response listing many services of the same type on the same host
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    for (int i = 0; i < ServiceCount; ++i) {
+        const QByteArray fqName = "Service " + QByteArray::number(i) + "." + Type;
+        QMdnsEngine::Record ptrRecord;
+        ptrRecord.setName(Type);
+        ptrRecord.setType(QMdnsEngine::PTR);
+        ptrRecord.setTarget(fqName);
+        message.addRecord(ptrRecord);
+        QMdnsEngine::Record srvRecord;
+        srvRecord.setName(fqName);
+        srvRecord.setType(QMdnsEngine::SRV);
+        srvRecord.setPort(8000 + i);
+        srvRecord.setTarget(Target);
+        message.addRecord(srvRecord);
+        QMdnsEngine::Record txtRecord;
+        txtRecord.setName(fqName);
+        txtRecord.setType(QMdnsEngine::TXT);
+        txtRecord.addAttribute("id", QByteArray::number(i));
+        message.addRecord(txtRecord);
+    }
+    QMdnsEngine::Record aRecord;
+    aRecord.setName(Target);
+    aRecord.setType(QMdnsEngine::A);
+    aRecord.setAddress(QHostAddress("192.168.1.10"));
+    message.addRecord(aRecord);
+    return message;
+}
+
+QTEST_MAIN(BenchDns)
+#include "BenchDns.moc"
@@ -0,0 +1,102 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/hostname.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/provider.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+#include <qmdnsengine/service.h>
+
+#include "common/testserver.h"
+
+const QByteArray Type = "_test._tcp.local.";
+
+// Queries from a port other than the mDNS port are answered immediately,
+// which allows the reply to be generated synchronously
+const quint16 LegacyPort = 50000;
+
+class BenchProvider : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void benchReply_data();
+    void benchReply();
+};
+
+void BenchProvider::benchReply_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("10") << 10;
+    QTest::newRow("100") << 100;
+}
+
+void BenchProvider::benchReply()
+{
+    QFETCH(int, count);
+
+    TestServer server;
+    QMdnsEngine::Hostname hostname(&server);
+    for (int i = 0; i < count; ++i) {
+        QMdnsEngine::Service service;
+        service.setName("Service " + QByteArray::number(i));
+        service.setType(Type);
+        service.setPort(1234);
+        service.setAttributes({{"id", QByteArray::number(i)}});
+        QMdnsEngine::Provider *provider = new QMdnsEngine::Provider(&server, &hostname, &server);
+        provider->update(service);
+    }
+
+    // Wait for the last of the services to be announced
+    QMdnsEngine::Record record;
+    const QByteArray lastFqName = "Service " + QByteArray::number(count - 1) + "." + Type;
+    QTRY_VERIFY_WITH_TIMEOUT(server.cache()->lookupRecord(lastFqName, QMdnsEngine::SRV, record), 10000);
+
+    // Each query is answered with the PTR, SRV and TXT records of every
+    // service along with the addresses of the host
+    QMdnsEngine::Query query;
+    query.setName(Type);
+    query.setType(QMdnsEngine::PTR);
+    QMdnsEngine::Message message;
+    message.setAddress(QHostAddress("192.168.1.20"));
+    message.setPort(LegacyPort);
+    message.addQuery(query);
+
+    QBENCHMARK {
+        server.clearReceivedMessages();
+        server.deliverMessage(message);
+    }
+    QCOMPARE(server.receivedMessages().count(), 1);
+}
+
+QTEST_MAIN(BenchProvider)
+#include "BenchProvider.moc"
@@ -0,0 +1,74 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QDebug>
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/browser.h>
+#include <qmdnsengine/cache.h>
+#include <qmdnsengine/mdns.h>
+
+#include "common/replayserver.h"
+
+// Environment variable holding the path of the capture to replay
+const char *CaptureVariable = "QMDNSENGINE_REPLAY_CAPTURE";
+
+class BenchReplay : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void initTestCase();
+    void benchBrowser();
+
+private:
+
+    ReplayServer mServer;
+};
+
+void BenchReplay::initTestCase()
+{
+    if (!qEnvironmentVariableIsSet(CaptureVariable)) {
+        QSKIP("set QMDNSENGINE_REPLAY_CAPTURE to the path of a capture to replay");
+    }
+    QVERIFY2(mServer.load(QString::fromLocal8Bit(qgetenv(CaptureVariable))),
+             qPrintable(mServer.errorString()));
+    qDebug() << mServer.packetCount() << "packets loaded," << mServer.skippedCount() << "frames skipped";
+}
+
+void BenchReplay::benchBrowser()
+{
+    // Browse for every service type, as a browser listing everything on the
+    // network would
+    QBENCHMARK {
+        QMdnsEngine::Cache cache;
+        QMdnsEngine::Browser browser(&mServer, QMdnsEngine::MdnsBrowseType, &cache);
+        mServer.replay(ReplayServer::AsFastAsPossible);
+    }
+}
+
+QTEST_MAIN(BenchReplay)
+#include "BenchReplay.moc"
@@ -81,6 +81,17 @@ Q_SIGNALS:
      * @param message brief description of the error
      */
     void error(const QString &message);
+
+    /**
+     * @brief Indicate that the network interfaces have changed
+     *
+     * This is emitted when an interface used by the server is added or
+     * removed, or when the addresses assigned to one change; interfaces the
+     * server does not send on (such as those excluded by its filter) are
+     * ignored. Records are announced again when this happens. Implementations that do not watch the
+     * interfaces never emit it.
+     */
+    void interfacesChanged();
 };
 
 }
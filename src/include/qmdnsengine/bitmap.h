@@ -25,6 +25,8 @@
 #ifndef QMDNSENGINE_BITMAP_H
 #define QMDNSENGINE_BITMAP_H
 
+#include <QSharedDataPointer>
+
 #include "qmdnsengine_export.h"
 
 namespace QMdnsEngine
@@ -57,10 +59,22 @@ public:
      */
     Bitmap &operator=(const Bitmap &other);
 
+    /**
+     * @brief Move constructor
+     *
+     * The moved-from bitmap is left empty, as if it had just been created.
+     */
+    Bitmap(Bitmap &&other) noexcept;
+
+    /**
+     * @brief Move assignment operator
+     */
+    Bitmap &operator=(Bitmap &&other) noexcept;
+
     /**
      * @brief Equality operator
      */
-    bool operator==(const Bitmap &other);
+    bool operator==(const Bitmap &other) const;
 
     /**
      * @brief Destroy the bitmap
@@ -92,7 +106,7 @@ public:
 
 private:
 
-    BitmapPrivate *const d;
+    QSharedDataPointer<BitmapPrivate> d;
 };
 
 }
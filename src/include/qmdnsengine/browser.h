@@ -28,6 +28,8 @@
 #include <QByteArray>
 #include <QObject>
 
+#include <qmdnsengine/statistics.h>
+
 #include "qmdnsengine_export.h"
 
 namespace QMdnsEngine
@@ -84,6 +86,44 @@ public:
      */
     Browser(AbstractServer *server, const QByteArray &type, Cache *cache = 0, QObject *parent = 0);
 
+    /**
+     * @brief Retrieve the interval in milliseconds after the first query
+     */
+    int minimumQueryInterval() const;
+
+    /**
+     * @brief Set the interval in milliseconds after the first query
+     *
+     * The first query is sent as soon as the browser is created. The
+     * interval until the next query starts at this value (one second by
+     * default) and doubles after each query until it reaches the maximum.
+     * The sequence begins again whenever the interfaces of the server
+     * change, and when either interval is set.
+     */
+    void setMinimumQueryInterval(int minimumQueryInterval);
+
+    /**
+     * @brief Retrieve the longest interval in milliseconds between queries
+     */
+    int maximumQueryInterval() const;
+
+    /**
+     * @brief Set the longest interval in milliseconds between queries
+     *
+     * RFC 6762 (section 5.2) suggests that the interval should reach at
+     * least an hour, which is the default. The maximum is never less than
+     * the minimum interval.
+     */
+    void setMaximumQueryInterval(int maximumQueryInterval);
+
+    /**
+     * @brief Retrieve a snapshot of the statistics for the browser
+     *
+     * If the browser created its own cache, the statistics for the cache and
+     * the queries sent to refresh its records are included.
+     */
+    Statistics statistics() const;
+
 Q_SIGNALS:
 
     /**
@@ -28,6 +28,8 @@
 #include <QList>
 #include <QObject>
 
+#include <qmdnsengine/statistics.h>
+
 #include "qmdnsengine_export.h"
 
 namespace QMdnsEngine
@@ -105,6 +107,23 @@ public:
      */
     bool lookupRecords(const QByteArray &name, quint16 type, QList<Record> &records) const;
 
+    /**
+     * @brief Retrieve the records to include as known answers in a query
+     * @param name name of records to retrieve
+     * @param type type of records to retrieve
+     * @param records storage for the records retrieved
+     * @return true if records were retrieved
+     *
+     * Records are only retrieved while at least half of their TTL remains,
+     * with the TTL reduced to the time remaining (RFC 6762, section 7.1).
+     */
+    bool lookupKnownAnswers(const QByteArray &name, quint16 type, QList<Record> &records) const;
+
+    /**
+     * @brief Retrieve a snapshot of the statistics for the cache
+     */
+    Statistics statistics() const;
+
 Q_SIGNALS:
 
     /**
@@ -112,7 +131,8 @@ Q_SIGNALS:
      * @param record reference to the record that will soon expire
      *
      * This signal is emitted when a record reaches approximately 50%, 85%,
-     * 90%, and 95% of its lifetime.
+     * 90%, and 95% of its lifetime, plus a random offset of up to 2% of its
+     * TTL.
      */
     void shouldQuery(const Record &record);
 
@@ -26,6 +26,7 @@
 #define QMDNSENGINE_DNS_H
 
 #include <QByteArray>
+#include <QList>
 #include <QMap>
 
 #include "qmdnsengine_export.h"
@@ -111,6 +112,21 @@ QMDNSENGINE_EXPORT bool fromPacket(const QByteArray &packet, Message &message);
  */
 QMDNSENGINE_EXPORT void toPacket(const Message &message, QByteArray &packet);
 
+/**
+ * @brief Create one or more raw DNS packets from a Message
+ * @param message Message to create the packets from
+ * @param maxSize maximum size of each packet
+ * @return list of raw DNS packets
+ *
+ * Queries and records are added to a packet until the next one would make
+ * it larger than maxSize, at which point a new packet is started. When the
+ * known answers of a query are split, each packet except the last has the
+ * TC bit set so that responders wait for the remaining known answers.
+ * Responses are simply split into several complete packets. A single query
+ * or record larger than maxSize is placed in a packet by itself.
+ */
+QMDNSENGINE_EXPORT QList<QByteArray> toPackets(const Message &message, int maxSize);
+
 /**
  * @brief Retrieve the string representation of a DNS type
  * @param type integer type
@@ -0,0 +1,197 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_INTERFACEFILTER_H
+#define QMDNSENGINE_INTERFACEFILTER_H
+
+#include <functional>
+
+#include <QAbstractSocket>
+#include <QList>
+#include <QSharedDataPointer>
+#include <QStringList>
+
+#include "qmdnsengine_export.h"
+
+class QNetworkInterface;
+
+namespace QMdnsEngine
+{
+
+class QMDNSENGINE_EXPORT InterfaceFilterPrivate;
+
+/**
+ * @brief Selection of the network interfaces used by a server
+ *
+ * By default, [Server](@ref QMdnsEngine::Server) joins the mDNS multicast
+ * groups and sends multicast messages on every interface that supports
+ * multicast. A filter restricts this to some of the interfaces, which avoids
+ * receiving traffic from (and sending it to) networks that are of no
+ * interest, such as the virtual interfaces created for containers:
+ *
+ * @code
+ * QMdnsEngine::InterfaceFilter filter;
+ * filter.setDeniedNames({"veth*", "br-*", "docker*"});
+ * server.setInterfaceFilter(filter);
+ * @endcode
+ *
+ * An interface is used if it is not denied by name or index, if it matches
+ * one of the allowed names or indexes (when any are set), and if the
+ * predicate (when set) accepts it.
+ */
+class QMDNSENGINE_EXPORT InterfaceFilter
+{
+public:
+
+    /**
+     * @brief Function deciding whether an interface may be used
+     */
+    typedef std::function<bool(const QNetworkInterface &)> Predicate;
+
+    /**
+     * @brief Create a filter that accepts every interface
+     */
+    InterfaceFilter();
+
+    /**
+     * @brief Create a copy of an existing filter
+     */
+    InterfaceFilter(const InterfaceFilter &other);
+
+    /**
+     * @brief Assignment operator
+     */
+    InterfaceFilter &operator=(const InterfaceFilter &other);
+
+    /**
+     * @brief Move constructor
+     *
+     * The moved-from filter is left empty, accepting every interface.
+     */
+    InterfaceFilter(InterfaceFilter &&other) noexcept;
+
+    /**
+     * @brief Move assignment operator
+     */
+    InterfaceFilter &operator=(InterfaceFilter &&other) noexcept;
+
+    /**
+     * @brief Destroy the filter
+     */
+    virtual ~InterfaceFilter();
+
+    /**
+     * @brief Retrieve the name patterns of the interfaces that may be used
+     */
+    QStringList allowedNames() const;
+
+    /**
+     * @brief Set the name patterns of the interfaces that may be used
+     *
+     * Patterns may contain the wildcards "*" (any number of characters) and
+     * "?" (a single character). An empty list allows any name.
+     */
+    void setAllowedNames(const QStringList &allowedNames);
+
+    /**
+     * @brief Retrieve the name patterns of the interfaces that must not be used
+     */
+    QStringList deniedNames() const;
+
+    /**
+     * @brief Set the name patterns of the interfaces that must not be used
+     *
+     * Patterns are matched in the same way as setAllowedNames() and take
+     * precedence over it.
+     */
+    void setDeniedNames(const QStringList &deniedNames);
+
+    /**
+     * @brief Retrieve the indexes of the interfaces that may be used
+     */
+    QList<int> allowedIndexes() const;
+
+    /**
+     * @brief Set the indexes of the interfaces that may be used
+     *
+     * An interface matching either an allowed name or an allowed index may
+     * be used. An empty list (with no allowed names) allows any interface.
+     */
+    void setAllowedIndexes(const QList<int> &allowedIndexes);
+
+    /**
+     * @brief Retrieve the indexes of the interfaces that must not be used
+     */
+    QList<int> deniedIndexes() const;
+
+    /**
+     * @brief Set the indexes of the interfaces that must not be used
+     */
+    void setDeniedIndexes(const QList<int> &deniedIndexes);
+
+    /**
+     * @brief Retrieve the protocols that are used
+     */
+    QAbstractSocket::NetworkLayerProtocol protocol() const;
+
+    /**
+     * @brief Set the protocols that are used
+     *
+     * With QAbstractSocket::IPv4Protocol or QAbstractSocket::IPv6Protocol,
+     * the server neither binds a socket for nor sends messages over the
+     * other protocol. The default is QAbstractSocket::AnyIPProtocol.
+     */
+    void setProtocol(QAbstractSocket::NetworkLayerProtocol protocol);
+
+    /**
+     * @brief Retrieve the predicate for the filter
+     */
+    Predicate predicate() const;
+
+    /**
+     * @brief Set a predicate that must accept each interface used
+     *
+     * The predicate is called whenever the interfaces are scanned, which
+     * happens in the I/O thread of the server if it has one.
+     */
+    void setPredicate(const Predicate &predicate);
+
+    /**
+     * @brief Determine whether a protocol is used
+     */
+    bool acceptsProtocol(QAbstractSocket::NetworkLayerProtocol protocol) const;
+
+    /**
+     * @brief Determine whether an interface may be used
+     */
+    bool acceptsInterface(const QNetworkInterface &networkInterface) const;
+
+private:
+
+    QSharedDataPointer<InterfaceFilterPrivate> d;
+};
+
+}
+
+#endif // QMDNSENGINE_INTERFACEFILTER_H
@@ -53,6 +53,14 @@ QMDNSENGINE_EXPORT extern const QHostAddress MdnsIpv6Address;
  */
 QMDNSENGINE_EXPORT extern const QByteArray MdnsBrowseType;
 
+/**
+ * @brief Default maximum size of a packet
+ *
+ * This allows a packet to be sent on an Ethernet link (with a 1500-byte MTU)
+ * without being fragmented.
+ */
+QMDNSENGINE_EXPORT extern const int MdnsMaxPacketSize;
+
 }
 
 #endif // QMDNSENGINE_MDNS_H
@@ -27,6 +27,7 @@
 
 #include <QHostAddress>
 #include <QList>
+#include <QSharedDataPointer>
 
 #include "qmdnsengine_export.h"
 
@@ -76,6 +77,18 @@ public:
      */
     Message &operator=(const Message &other);
 
+    /**
+     * @brief Move constructor
+     *
+     * The moved-from message is left empty, as if it had just been created.
+     */
+    Message(Message &&other) noexcept;
+
+    /**
+     * @brief Move assignment operator
+     */
+    Message &operator=(Message &&other) noexcept;
+
     /**
      * @brief Destroy the message
      */
@@ -116,6 +129,25 @@ public:
      */
     void setPort(quint16 port);
 
+    /**
+     * @brief Retrieve the index of the network interface for the message
+     *
+     * When receiving messages, this is the index of the interface that the
+     * message arrived on, if the platform reports it. The index is 0 when
+     * the interface is not known.
+     */
+    int interfaceIndex() const;
+
+    /**
+     * @brief Set the index of the network interface for the message
+     *
+     * When sending messages, a nonzero index restricts the message to the
+     * interface with that index (see QNetworkInterface::index()). With the
+     * default of 0, [Server](@ref QMdnsEngine::Server) sends multicast
+     * messages passed to sendMessageToAll() on every interface.
+     */
+    void setInterfaceIndex(int interfaceIndex);
+
     /**
      * @brief Retrieve the transaction ID for the message
      *
@@ -176,14 +208,14 @@ public:
      * @brief Reply to another message
      *
      * The message will be correctly initialized to respond to the other
-     * message. This includes setting the target address, port, and
-     * transaction ID.
+     * message. This includes setting the target address, port, interface,
+     * and transaction ID.
      */
     void reply(const Message &other);
 
 private:
 
-    MessagePrivate *const d;
+    QSharedDataPointer<MessagePrivate> d;
 };
 
 }
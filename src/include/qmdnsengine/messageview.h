@@ -0,0 +1,172 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_MESSAGEVIEW_H
+#define QMDNSENGINE_MESSAGEVIEW_H
+
+#include <QByteArray>
+#include <QSharedDataPointer>
+
+#include <qmdnsengine/queryview.h>
+#include <qmdnsengine/recordview.h>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+class Message;
+
+class QMDNSENGINE_EXPORT MessageViewPrivate;
+
+/**
+ * @brief Non-owning view of a raw DNS message
+ *
+ * Unlike [Message](@ref QMdnsEngine::Message), which decodes every query and
+ * record when a packet is parsed, this class only indexes the packet. The
+ * location, type, class, and TTL of each query and record are recorded, but
+ * names, record data, and TXT attributes are only decoded when requested
+ * through [QueryView](@ref QMdnsEngine::QueryView) and
+ * [RecordView](@ref QMdnsEngine::RecordView).
+ *
+ * This makes it inexpensive to examine a message and skip the records that
+ * are not of interest:
+ *
+ * @code
+ * QMdnsEngine::MessageView view;
+ * if (view.parse(packet)) {
+ *     for (int i = 0; i < view.recordCount(); ++i) {
+ *         QMdnsEngine::RecordView record = view.record(i);
+ *         if (record.type() == QMdnsEngine::SRV && record.nameEquals(name)) {
+ *             qDebug() << "Port:" << record.port();
+ *         }
+ *     }
+ * }
+ * @endcode
+ *
+ * A complete [Message](@ref QMdnsEngine::Message) can still be obtained
+ * with toMessage() when it is needed. The server itself decodes every
+ * packet it receives into a message; this class is meant for code that
+ * examines raw packets directly.
+ *
+ * Copies of a view, and the query and record views taken from it, share
+ * the same index. Parsing another packet starts a new index, so views taken
+ * earlier continue to refer to the packet they were taken from.
+ */
+class QMDNSENGINE_EXPORT MessageView
+{
+public:
+
+    /**
+     * @brief Create an empty view
+     */
+    MessageView();
+
+    /**
+     * @brief Create a copy of an existing view
+     */
+    MessageView(const MessageView &other);
+
+    /**
+     * @brief Assignment operator
+     */
+    MessageView &operator=(const MessageView &other);
+
+    /**
+     * @brief Destroy the view
+     */
+    virtual ~MessageView();
+
+    /**
+     * @brief Index a raw DNS packet
+     * @param packet raw DNS packet data
+     * @return true if no errors occurred
+     *
+     * The packet is not copied - its data is shared with the view, so a
+     * packet created with QByteArray::fromRawData() must remain valid for as
+     * long as the view and any query or record views taken from it are used.
+     */
+    bool parse(const QByteArray &packet);
+
+    /**
+     * @brief Retrieve the packet being viewed
+     */
+    QByteArray packet() const;
+
+    /**
+     * @brief Retrieve the transaction ID for the message
+     */
+    quint16 transactionId() const;
+
+    /**
+     * @brief Determine if the message is a response
+     */
+    bool isResponse() const;
+
+    /**
+     * @brief Determine if the message is truncated
+     */
+    bool isTruncated() const;
+
+    /**
+     * @brief Retrieve the number of queries in the message
+     */
+    int queryCount() const;
+
+    /**
+     * @brief Retrieve a view of the query at the specified index
+     *
+     * The query view remains valid after this view is destroyed.
+     */
+    QueryView query(int index) const;
+
+    /**
+     * @brief Retrieve the number of records in the message
+     */
+    int recordCount() const;
+
+    /**
+     * @brief Retrieve a view of the record at the specified index
+     *
+     * The record view remains valid after this view is destroyed.
+     */
+    RecordView record(int index) const;
+
+    /**
+     * @brief Decode the entire message
+     * @param message reference to Message to populate
+     * @return true if no errors occurred
+     *
+     * The result is identical to calling fromPacket() with the packet.
+     */
+    bool toMessage(Message &message) const;
+
+private:
+
+    QExplicitlySharedDataPointer<MessageViewPrivate> d;
+};
+
+}
+
+#endif // QMDNSENGINE_MESSAGEVIEW_H
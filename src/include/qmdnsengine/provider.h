@@ -59,6 +59,9 @@ class QMDNSENGINE_EXPORT ProviderPrivate;
  * @endcode
  *
  * This method can also be used to update the provider's records.
+ *
+ * The records of all providers using the same server are answered together,
+ * so any number of providers may be created to publish many services.
  */
 class QMDNSENGINE_EXPORT Provider : public QObject
 {
@@ -26,6 +26,7 @@
 #define QMDNSENGINE_QUERY_H
 
 #include <QByteArray>
+#include <QSharedDataPointer>
 
 #include "qmdnsengine_export.h"
 
@@ -67,6 +68,18 @@ public:
      */
     Query &operator=(const Query &other);
 
+    /**
+     * @brief Move constructor
+     *
+     * The moved-from query is left empty, as if it had just been created.
+     */
+    Query(Query &&other) noexcept;
+
+    /**
+     * @brief Move assignment operator
+     */
+    Query &operator=(Query &&other) noexcept;
+
     /**
      * @brief Destroy the query
      */
@@ -106,7 +119,7 @@ public:
 
 private:
 
-    QueryPrivate *const d;
+    QSharedDataPointer<QueryPrivate> d;
 };
 
 QMDNSENGINE_EXPORT QDebug operator<<(QDebug dbg, const Query &query);
@@ -0,0 +1,106 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_QUERYVIEW_H
+#define QMDNSENGINE_QUERYVIEW_H
+
+#include <QByteArray>
+#include <QSharedDataPointer>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+class MessageViewPrivate;
+class Query;
+
+/**
+ * @brief Non-owning view of a query in a raw DNS message
+ *
+ * Instances of this class are obtained from
+ * [MessageView](@ref QMdnsEngine::MessageView) and refer directly to the
+ * packet it indexed, which they keep alive. The name is only decoded when name() is called.
+ */
+class QMDNSENGINE_EXPORT QueryView
+{
+public:
+
+    /**
+     * @brief Create a copy of an existing query view
+     */
+    QueryView(const QueryView &other);
+
+    /**
+     * @brief Assignment operator
+     */
+    QueryView &operator=(const QueryView &other);
+
+    /**
+     * @brief Destroy the query view
+     */
+    virtual ~QueryView();
+
+    /**
+     * @brief Retrieve the name being queried
+     */
+    QByteArray name() const;
+
+    /**
+     * @brief Determine if the name being queried matches
+     *
+     * This compares the name without decoding it.
+     */
+    bool nameEquals(const QByteArray &name) const;
+
+    /**
+     * @brief Retrieve the type of record being queried
+     */
+    quint16 type() const;
+
+    /**
+     * @brief Determine if a unicast response is desired
+     */
+    bool unicastResponse() const;
+
+    /**
+     * @brief Decode the query
+     * @param query reference to Query to populate
+     * @return true if no errors occurred
+     */
+    bool toQuery(Query &query) const;
+
+private:
+
+    friend class MessageView;
+
+    QueryView(const QExplicitlySharedDataPointer<MessageViewPrivate> &d, int index);
+
+    QExplicitlySharedDataPointer<MessageViewPrivate> d;
+    int index;
+};
+
+}
+
+#endif // QMDNSENGINE_QUERYVIEW_H
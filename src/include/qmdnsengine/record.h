@@ -28,6 +28,7 @@
 #include <QByteArray>
 #include <QHostAddress>
 #include <QMap>
+#include <QSharedDataPointer>
 
 #include <qmdnsengine/bitmap.h>
 
@@ -75,6 +76,18 @@ public:
      */
     Record &operator=(const Record &other);
 
+    /**
+     * @brief Move constructor
+     *
+     * The moved-from record is left empty, as if it had just been created.
+     */
+    Record(Record &&other) noexcept;
+
+    /**
+     * @brief Move assignment operator
+     */
+    Record &operator=(Record &&other) noexcept;
+
     /**
      * @brief Equality operator
      */
@@ -245,7 +258,9 @@ public:
 
 private:
 
-    RecordPrivate *const d;
+    friend class PacketWriter;
+
+    QSharedDataPointer<RecordPrivate> d;
 };
 
 QMDNSENGINE_EXPORT QDebug operator<<(QDebug dbg, const Record &record);
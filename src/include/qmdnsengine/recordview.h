@@ -0,0 +1,165 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_RECORDVIEW_H
+#define QMDNSENGINE_RECORDVIEW_H
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QMap>
+#include <QSharedDataPointer>
+
+#include <qmdnsengine/bitmap.h>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+class MessageViewPrivate;
+class Record;
+
+/**
+ * @brief Non-owning view of a record in a raw DNS message
+ *
+ * Instances of this class are obtained from
+ * [MessageView](@ref QMdnsEngine::MessageView) and refer directly to the
+ * packet it indexed, which they keep alive. The type, TTL, and cache flush bit are available
+ * immediately; the name and record data are decoded each time they are
+ * requested, so a record that is not of interest costs nothing more than a
+ * call to type() or nameEquals().
+ */
+class QMDNSENGINE_EXPORT RecordView
+{
+public:
+
+    /**
+     * @brief Create a copy of an existing record view
+     */
+    RecordView(const RecordView &other);
+
+    /**
+     * @brief Assignment operator
+     */
+    RecordView &operator=(const RecordView &other);
+
+    /**
+     * @brief Destroy the record view
+     */
+    virtual ~RecordView();
+
+    /**
+     * @brief Retrieve the name of the record
+     */
+    QByteArray name() const;
+
+    /**
+     * @brief Determine if the name of the record matches
+     *
+     * This compares the name without decoding it.
+     */
+    bool nameEquals(const QByteArray &name) const;
+
+    /**
+     * @brief Determine if the name of the record ends with a suffix
+     *
+     * This compares the name without decoding it.
+     */
+    bool nameEndsWith(const QByteArray &suffix) const;
+
+    /**
+     * @brief Retrieve the type of the record
+     */
+    quint16 type() const;
+
+    /**
+     * @brief Determine whether to replace or append to existing records
+     */
+    bool flushCache() const;
+
+    /**
+     * @brief Retrieve the TTL (time to live) for the record
+     */
+    quint32 ttl() const;
+
+    /**
+     * @brief Retrieve the address for A and AAAA records
+     */
+    QHostAddress address() const;
+
+    /**
+     * @brief Retrieve the target for PTR and SRV records
+     */
+    QByteArray target() const;
+
+    /**
+     * @brief Retrieve the next domain name for NSEC records
+     */
+    QByteArray nextDomainName() const;
+
+    /**
+     * @brief Retrieve the priority for SRV records
+     */
+    quint16 priority() const;
+
+    /**
+     * @brief Retrieve the weight for SRV records
+     */
+    quint16 weight() const;
+
+    /**
+     * @brief Retrieve the port for SRV records
+     */
+    quint16 port() const;
+
+    /**
+     * @brief Retrieve attributes for TXT records
+     */
+    QMap<QByteArray, QByteArray> attributes() const;
+
+    /**
+     * @brief Retrieve the bitmap for NSEC records
+     */
+    Bitmap bitmap() const;
+
+    /**
+     * @brief Decode the record
+     * @param record reference to Record to populate
+     * @return true if no errors occurred
+     */
+    bool toRecord(Record &record) const;
+
+private:
+
+    friend class MessageView;
+
+    RecordView(const QExplicitlySharedDataPointer<MessageViewPrivate> &d, int index);
+
+    QExplicitlySharedDataPointer<MessageViewPrivate> d;
+    int index;
+};
+
+}
+
+#endif // QMDNSENGINE_RECORDVIEW_H
@@ -26,6 +26,8 @@
 #define QMDNSENGINE_SERVER_H
 
 #include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/interfacefilter.h>
+#include <qmdnsengine/statistics.h>
 
 #include "qmdnsengine_export.h"
 
@@ -45,7 +47,13 @@ class QMDNSENGINE_EXPORT ServerPrivate;
  *
  * The class takes care of watching for the addition and removal of network
  * interfaces, automatically joining multicast groups when new interfaces are
- * available.
+ * available. On Linux, the kernel reports changes to the interfaces as they
+ * happen; elsewhere, the interfaces are checked once per minute.
+ *
+ * Received messages carry the index of the interface they arrived on (see
+ * Message::interfaceIndex()), so that replies are only sent on that
+ * interface. Messages passed to sendMessageToAll() are encoded once and sent
+ * on every interface that is up and has an address for the protocol.
  */
 class QMDNSENGINE_EXPORT Server : public AbstractServer
 {
@@ -58,6 +66,170 @@ public:
      */
     explicit Server(QObject *parent = 0);
 
+    /**
+     * @brief Determine whether the server uses a thread for I/O
+     */
+    bool isIoThreadEnabled() const;
+
+    /**
+     * @brief Set whether the server uses a thread for I/O
+     *
+     * By default, datagrams are received, decoded and sent in the thread
+     * that the server belongs to. When enabled, this work is done in a
+     * dedicated thread instead. Messages received in a burst are passed to
+     * the thread of the server together and the messageReceived() signal is
+     * still emitted in that thread. Sending a message only queues it for the
+     * I/O thread. Changing this setting rebinds the sockets; messages that
+     * are waiting to be sent or delivered are not lost.
+     */
+    void setIoThreadEnabled(bool ioThreadEnabled);
+
+    /**
+     * @brief Retrieve the filter selecting the interfaces that are used
+     */
+    InterfaceFilter interfaceFilter() const;
+
+    /**
+     * @brief Set the filter selecting the interfaces that are used
+     *
+     * The mDNS multicast groups are only joined on the interfaces accepted
+     * by the filter, multicast messages are only sent on those interfaces
+     * and datagrams arriving on any other interface are discarded. Groups
+     * already joined on interfaces that the filter excludes are left. By
+     * default, every interface is used.
+     */
+    void setInterfaceFilter(const InterfaceFilter &interfaceFilter);
+
+    /**
+     * @brief Retrieve the maximum number of datagrams read at once
+     */
+    int receiveBatchSize() const;
+
+    /**
+     * @brief Set the maximum number of datagrams read at once
+     *
+     * All datagrams waiting on a socket are read each time it becomes
+     * readable. On Linux, they are read in batches of up to this many
+     * datagrams with a single system call. The default is 32.
+     */
+    void setReceiveBatchSize(int receiveBatchSize);
+
+    /**
+     * @brief Retrieve the number of datagrams that were dropped
+     *
+     * This includes datagrams too large to be mDNS messages and, on Linux,
+     * datagrams discarded by the kernel because the receive buffer was full.
+     */
+    quint64 droppedDatagrams() const;
+
+    /**
+     * @brief Retrieve a snapshot of the statistics for the server
+     *
+     * In addition to the traffic handled by the server, this includes the
+     * answers merged and suppressed when responding to queries.
+     */
+    Statistics statistics() const;
+
+    /**
+     * @brief Determine whether histograms are recorded
+     */
+    bool histogramsEnabled() const;
+
+    /**
+     * @brief Set whether histograms are recorded
+     *
+     * Recording the time spent handling each message requires reading the
+     * clock twice per message, so histograms are disabled by default.
+     */
+    void setHistogramsEnabled(bool histogramsEnabled);
+
+    /**
+     * @brief Retrieve the maximum size of a packet sent by the server
+     */
+    int maxPacketSize() const;
+
+    /**
+     * @brief Set the maximum size of a packet sent by the server
+     *
+     * Messages that do not fit are split into several packets (see
+     * toPackets()) instead of being fragmented at the IP layer. The default
+     * of MdnsMaxPacketSize suits a standard Ethernet MTU and may be raised
+     * on links with jumbo frames. The size is kept between 512 and 9000.
+     */
+    void setMaxPacketSize(int maxPacketSize);
+
+    /**
+     * @brief Retrieve the time in microseconds outgoing datagrams are held
+     */
+    int sendBatchDelay() const;
+
+    /**
+     * @brief Set the time in microseconds outgoing datagrams are held
+     *
+     * Datagrams are queued and sent together (on Linux, with a single
+     * system call per batch). With the default of 0, the queue is sent once
+     * control returns to the event loop; a longer delay collects more
+     * datagrams per batch at the cost of latency. The delay is rounded up to
+     * whole milliseconds.
+     */
+    void setSendBatchDelay(int sendBatchDelay);
+
+    /**
+     * @brief Retrieve the time in milliseconds duplicate datagrams are dropped
+     */
+    int duplicateWindow() const;
+
+    /**
+     * @brief Set the time in milliseconds duplicate datagrams are dropped
+     *
+     * On hosts with several interfaces or both protocols enabled, the same
+     * datagram is often received more than once. When the window is
+     * nonzero, a datagram identical to one received within the window is
+     * dropped before it is decoded, and the DuplicateHits and
+     * DuplicateMisses counters of the statistics are updated. The window is
+     * 0 (disabled) by default.
+     */
+    void setDuplicateWindow(int duplicateWindow);
+
+    /**
+     * @brief Determine whether duplicates are detected regardless of source
+     */
+    bool duplicateIgnoresSource() const;
+
+    /**
+     * @brief Set whether duplicates are detected regardless of source
+     *
+     * By default, only datagrams from the same address and port are
+     * considered duplicates. Ignoring the source also drops a datagram
+     * received over IPv4 and again over IPv6. Replies to a query are only
+     * sent on the interface of the copy that was kept, so this is best
+     * suited to hosts that browse rather than respond on several networks.
+     */
+    void setDuplicateIgnoresSource(bool duplicateIgnoresSource);
+
+    /**
+     * @brief Determine whether messages sent by the server are received
+     */
+    bool ownMessagesDelivered() const;
+
+    /**
+     * @brief Set whether messages sent by the server are received
+     *
+     * Multicast packets sent by the server are looped back to it. By
+     * default, packets with the same contents as one sent during the last
+     * second that come from the mDNS port of a local address are dropped
+     * before they are decoded; instead, each multicast message is passed to
+     * the messageReceived() signal once, as it was sent, from the loopback
+     * address. Components sharing the server still see each other's
+     * messages without every packet being decoded again.
+     *
+     * Enable delivery to receive the looped-back packets themselves, once
+     * for each interface they were sent on. Since an identical packet sent
+     * by another process on the same host is otherwise dropped too, enable
+     * it when conflicts with other processes must be detected.
+     */
+    void setOwnMessagesDelivered(bool ownMessagesDelivered);
+
     /**
      * @brief Implementation of AbstractServer::sendMessage()
      */
@@ -29,6 +29,7 @@
 #include <QHostAddress>
 #include <QList>
 #include <QMap>
+#include <QSharedDataPointer>
 
 #include "qmdnsengine_export.h"
 
@@ -66,6 +67,18 @@ public:
      */
     Service &operator=(const Service &other);
 
+    /**
+     * @brief Move constructor
+     *
+     * The moved-from service is left empty, as if it had just been created.
+     */
+    Service(Service &&other) noexcept;
+
+    /**
+     * @brief Move assignment operator
+     */
+    Service &operator=(Service &&other) noexcept;
+
     /**
      * @brief Equality operator
      */
@@ -146,7 +159,7 @@ public:
 
 private:
 
-    ServicePrivate *const d;
+    QSharedDataPointer<ServicePrivate> d;
 };
 
 QMDNSENGINE_EXPORT QDebug operator<<(QDebug debug, const Service &service);
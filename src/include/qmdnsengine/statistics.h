@@ -0,0 +1,193 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_STATISTICS_H
+#define QMDNSENGINE_STATISTICS_H
+
+#include <QSharedDataPointer>
+#include <QVector>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+class QMDNSENGINE_EXPORT StatisticsPrivate;
+
+/**
+ * @brief Snapshot of runtime statistics
+ *
+ * [Server](@ref QMdnsEngine::Server), [Cache](@ref QMdnsEngine::Cache) and
+ * [Browser](@ref QMdnsEngine::Browser) each keep a set of counters while they
+ * run. Updating them costs an atomic increment, so they are always enabled,
+ * and a snapshot may be retrieved at any time (from any thread) with the
+ * statistics() method of each class. Counters that do not apply to a class
+ * are always zero.
+ *
+ * For example, to log the number of packets received every minute:
+ *
+ * @code
+ * QTimer timer;
+ * QObject::connect(&timer, &QTimer::timeout, [&server]() {
+ *     QMdnsEngine::Statistics statistics = server.statistics();
+ *     qDebug() << statistics.counter(QMdnsEngine::Statistics::PacketsReceived);
+ * });
+ * timer.start(60000);
+ * @endcode
+ */
+class QMDNSENGINE_EXPORT Statistics
+{
+public:
+
+    /**
+     * @brief Counters included in the statistics
+     */
+    enum Counter {
+        /// Datagrams received by the server
+        PacketsReceived,
+        /// Bytes received by the server
+        BytesReceived,
+        /// Datagrams sent by the server
+        PacketsSent,
+        /// Bytes sent by the server
+        BytesSent,
+        /// Datagrams received that could not be decoded
+        ParseFailures,
+        /// Datagrams dropped before they could be decoded
+        DroppedDatagrams,
+        /// Answers merged into a response already waiting to be sent
+        MergedAnswers,
+        /// Answers not sent because of known answers or rate limiting
+        SuppressedAnswers,
+        /// Records currently in the cache
+        CachedRecords,
+        /// Lookups performed in the cache
+        CacheLookups,
+        /// Lookups that found at least one record
+        CacheHits,
+        /// Lookups that found no records
+        CacheMisses,
+        /// Refresh and expiry triggers processed by the cache
+        TriggersFired,
+        /// Records removed from the cache once their TTL ran out
+        RecordsExpired,
+        /// Query messages sent
+        QueriesSent,
+        /// Times the queue of outgoing datagrams was sent
+        SendFlushes,
+        /// Datagrams dropped as copies of one received shortly before
+        DuplicateHits,
+        /// Datagrams checked for duplicates that were not copies
+        DuplicateMisses,
+        /// Datagrams sent by the server that were received back and dropped
+        OwnPacketsDropped,
+        /// Number of counters
+        CounterCount
+    };
+
+    /**
+     * @brief Histograms included in the statistics
+     *
+     * Histograms are only recorded when enabled for the server with
+     * Server::setHistogramsEnabled().
+     */
+    enum Histogram {
+        /// Size in bytes of each datagram received
+        PacketSize,
+        /// Time in microseconds spent handling each message received
+        HandlerLatency,
+        /// Number of datagrams sent each time the outgoing queue is sent
+        PacketsPerFlush,
+        /// Number of histograms
+        HistogramCount
+    };
+
+    /**
+     * @brief Number of buckets in each histogram
+     */
+    static const int BucketCount = 32;
+
+    /**
+     * @brief Create an empty set of statistics
+     */
+    Statistics();
+
+    /**
+     * @brief Create a copy of existing statistics
+     */
+    Statistics(const Statistics &other);
+
+    /**
+     * @brief Assignment operator
+     */
+    Statistics &operator=(const Statistics &other);
+
+    /**
+     * @brief Move constructor
+     *
+     * The moved-from statistics are left empty.
+     */
+    Statistics(Statistics &&other) noexcept;
+
+    /**
+     * @brief Move assignment operator
+     */
+    Statistics &operator=(Statistics &&other) noexcept;
+
+    /**
+     * @brief Add the counters and histograms of other statistics to these
+     *
+     * This can be used to combine the statistics of several objects.
+     */
+    Statistics &operator+=(const Statistics &other);
+
+    /**
+     * @brief Destroy the statistics
+     */
+    virtual ~Statistics();
+
+    /**
+     * @brief Retrieve the value of a counter
+     */
+    quint64 counter(Counter counter) const;
+
+    /**
+     * @brief Retrieve the buckets of a histogram
+     *
+     * Bucket 0 counts values of zero and bucket n counts values from
+     * 2<sup>n-1</sup> up to (but not including) 2<sup>n</sup>. The last
+     * bucket also counts every larger value.
+     */
+    QVector<quint64> histogram(Histogram histogram) const;
+
+private:
+
+    friend class StatisticsRecorder;
+
+    QSharedDataPointer<StatisticsPrivate> d;
+};
+
+}
+
+#endif // QMDNSENGINE_STATISTICS_H
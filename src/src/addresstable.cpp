@@ -0,0 +1,248 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QNetworkAddressEntry>
+
+#include "addresstable_p.h"
+
+using namespace QMdnsEngine;
+
+// Tables are rebuilt when used after this long, in case nothing has scanned
+// the interfaces in the meantime
+const qint64 MaxAge = 60 * 1000;
+
+// The current table is replaced under a lock; a table handed out remains
+// valid for as long as it is referenced
+struct SharedTable
+{
+    QMutex mutex;
+    QSharedPointer<const AddressTable> table;
+};
+
+static SharedTable &sharedTable()
+{
+    static SharedTable instance;
+    return instance;
+}
+
+// Create a mask for one 64-bit half of a key, given the number of prefix
+// bits that fall into it (shifting by 64 is undefined, hence the special case)
+static quint64 prefixMask(int length)
+{
+    return length <= 0 ? 0 : ~Q_UINT64_C(0) << (64 - qMin(length, 64));
+}
+
+AddressTable::AddressTable(const QList<QNetworkInterface> &interfaces)
+{
+    age.start();
+
+    QHash<int, QVector<Subnet>> subnets;
+    for (const QNetworkInterface &networkInterface : interfaces) {
+        const int index = networkInterface.index();
+        Interface &entry = entries[index];
+        entry.networkInterface = networkInterface;
+        order.append(index);
+
+        // Record each address and the subnet it belongs to; prefix lengths
+        // are converted to the shared 128-bit key space
+        const auto addressEntries = networkInterface.addressEntries();
+        for (const QNetworkAddressEntry &addressEntry : addressEntries) {
+            const QHostAddress address = addressEntry.ip();
+            Key key;
+            int bits;
+            if (!toKey(address, key, bits)) {
+                continue;
+            }
+            localAddresses.append(key);
+            if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+                entry.ipv4Addresses.append(address);
+            } else {
+                entry.ipv6Addresses.append(address);
+            }
+            const int prefixLength = addressEntry.prefixLength();
+            if (prefixLength >= 0 && prefixLength <= bits) {
+                const int length = prefixLength + 128 - bits;
+                subnets[length].append({mask(key, length), index});
+            }
+        }
+
+        // Multicast messages are sent on interfaces that are up and have an
+        // address for the protocol
+        const auto flags = networkInterface.flags();
+        if ((flags & QNetworkInterface::CanMulticast) && (flags & QNetworkInterface::IsUp)) {
+            if (!entry.ipv4Addresses.isEmpty()) {
+                ipv4Multicast.append(index);
+            }
+            if (!entry.ipv6Addresses.isEmpty()) {
+                ipv6Multicast.append(index);
+            }
+        }
+    }
+
+    // Longer prefixes are searched first; a stable sort keeps the first
+    // interface listed for a subnet that is shared by several interfaces
+    for (auto i = subnets.begin(); i != subnets.end(); ++i) {
+        std::stable_sort(i.value().begin(), i.value().end());
+        levels.append({i.key(), i.value()});
+    }
+    std::sort(levels.begin(), levels.end(), [](const Level &a, const Level &b) {
+        return a.prefixLength > b.prefixLength;
+    });
+    std::sort(localAddresses.begin(), localAddresses.end());
+}
+
+QSharedPointer<const AddressTable> AddressTable::current()
+{
+    SharedTable &shared = sharedTable();
+    QMutexLocker locker(&shared.mutex);
+    if (shared.table.isNull() || shared.table->age.hasExpired(MaxAge)) {
+        shared.table = QSharedPointer<const AddressTable>(
+            new AddressTable(QNetworkInterface::allInterfaces()));
+    }
+    return shared.table;
+}
+
+QSharedPointer<const AddressTable> AddressTable::refresh()
+{
+    // The interfaces are enumerated before taking the lock
+    QSharedPointer<const AddressTable> table(new AddressTable(QNetworkInterface::allInterfaces()));
+    SharedTable &shared = sharedTable();
+    QMutexLocker locker(&shared.mutex);
+    shared.table = table;
+    return table;
+}
+
+AddressTable::InterfaceAddresses AddressTable::usedAddresses(const InterfaceFilter &filter) const
+{
+    // Only the interfaces and protocols that a server with the filter sends
+    // multicast messages on are included, so that comparing the result of
+    // two scans ignores changes to every other interface
+    const bool ipv4 = filter.acceptsProtocol(QAbstractSocket::IPv4Protocol);
+    const bool ipv6 = filter.acceptsProtocol(QAbstractSocket::IPv6Protocol);
+    InterfaceAddresses used;
+    for (int index : order) {
+        const Interface &entry = *entries.constFind(index);
+        if (!filter.acceptsInterface(entry.networkInterface)) {
+            continue;
+        }
+        QList<QHostAddress> addresses;
+        if (ipv4 && ipv4Multicast.contains(index)) {
+            addresses.append(entry.ipv4Addresses);
+        }
+        if (ipv6 && ipv6Multicast.contains(index)) {
+            addresses.append(entry.ipv6Addresses);
+        }
+        if (!addresses.isEmpty()) {
+            used.insert(index, addresses);
+        }
+    }
+    return used;
+}
+
+QList<QNetworkInterface> AddressTable::interfaces() const
+{
+    QList<QNetworkInterface> interfaces;
+    for (int index : order) {
+        interfaces.append(entries.value(index).networkInterface);
+    }
+    return interfaces;
+}
+
+QNetworkInterface AddressTable::networkInterface(int interfaceIndex) const
+{
+    return entries.value(interfaceIndex).networkInterface;
+}
+
+QList<int> AddressTable::multicastInterfaces(QAbstractSocket::NetworkLayerProtocol protocol) const
+{
+    return protocol == QAbstractSocket::IPv4Protocol ? ipv4Multicast : ipv6Multicast;
+}
+
+int AddressTable::interfaceIndex(const QHostAddress &address) const
+{
+    Key key;
+    int bits;
+    if (!toKey(address, key, bits)) {
+        return 0;
+    }
+    for (const Level &level : levels) {
+        const Subnet subnet{mask(key, level.prefixLength), 0};
+        auto i = std::lower_bound(level.subnets.constBegin(), level.subnets.constEnd(), subnet);
+        if (i != level.subnets.constEnd() && i->network == subnet.network) {
+            return i->interfaceIndex;
+        }
+    }
+    return 0;
+}
+
+QHostAddress AddressTable::localAddress(int interfaceIndex, QAbstractSocket::NetworkLayerProtocol protocol) const
+{
+    auto i = entries.constFind(interfaceIndex);
+    if (i == entries.constEnd()) {
+        return QHostAddress();
+    }
+    const QList<QHostAddress> &addresses = protocol == QAbstractSocket::IPv4Protocol ?
+        i.value().ipv4Addresses : i.value().ipv6Addresses;
+    return addresses.isEmpty() ? QHostAddress() : addresses.first();
+}
+
+bool AddressTable::isLocalAddress(const QHostAddress &address) const
+{
+    Key key;
+    int bits;
+    return toKey(address, key, bits) &&
+            std::binary_search(localAddresses.constBegin(), localAddresses.constEnd(), key);
+}
+
+bool AddressTable::toKey(const QHostAddress &address, Key &key, int &bits)
+{
+    switch (address.protocol()) {
+    case QAbstractSocket::IPv4Protocol:
+        key = {0, Q_UINT64_C(0xffff00000000) | address.toIPv4Address()};
+        bits = 32;
+        return true;
+    case QAbstractSocket::IPv6Protocol:
+    {
+        const Q_IPV6ADDR ipv6Addr = address.toIPv6Address();
+        key = {0, 0};
+        for (int i = 0; i < 8; ++i) {
+            key.high = (key.high << 8) | ipv6Addr[i];
+            key.low = (key.low << 8) | ipv6Addr[i + 8];
+        }
+        bits = 128;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+AddressTable::Key AddressTable::mask(const Key &key, int prefixLength)
+{
+    return {key.high & prefixMask(prefixLength), key.low & prefixMask(prefixLength - 64)};
+}
@@ -0,0 +1,129 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_ADDRESSTABLE_P_H
+#define QMDNSENGINE_ADDRESSTABLE_P_H
+
+#include <QAbstractSocket>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QMap>
+#include <QNetworkInterface>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <qmdnsengine/interfacefilter.h>
+
+namespace QMdnsEngine
+{
+
+// Table of the addresses assigned to the local network interfaces, shared by
+// every server and hostname in the process; the subnets are indexed by prefix
+// length and kept sorted, so finding the interface on the same network as a
+// remote address takes a binary search per prefix length instead of walking
+// every interface - a table is never modified once built and is replaced
+// whenever the interfaces are scanned again
+class AddressTable
+{
+public:
+
+    // Addresses of each interface used for multicast, by interface index
+    typedef QMap<int, QList<QHostAddress>> InterfaceAddresses;
+
+    explicit AddressTable(const QList<QNetworkInterface> &interfaces);
+
+    static QSharedPointer<const AddressTable> current();
+    static QSharedPointer<const AddressTable> refresh();
+
+    InterfaceAddresses usedAddresses(const InterfaceFilter &filter) const;
+
+    QList<QNetworkInterface> interfaces() const;
+    QNetworkInterface networkInterface(int interfaceIndex) const;
+    QList<int> multicastInterfaces(QAbstractSocket::NetworkLayerProtocol protocol) const;
+
+    int interfaceIndex(const QHostAddress &address) const;
+    QHostAddress localAddress(int interfaceIndex, QAbstractSocket::NetworkLayerProtocol protocol) const;
+    bool isLocalAddress(const QHostAddress &address) const;
+
+private:
+
+    // Addresses are stored as 128-bit keys, with IPv4 addresses mapped into
+    // the IPv6 address space so that a single index serves both protocols
+    struct Key
+    {
+        quint64 high;
+        quint64 low;
+
+        bool operator<(const Key &other) const
+        {
+            return high < other.high || (high == other.high && low < other.low);
+        }
+
+        bool operator==(const Key &other) const
+        {
+            return high == other.high && low == other.low;
+        }
+    };
+
+    struct Subnet
+    {
+        Key network;
+        int interfaceIndex;
+
+        bool operator<(const Subnet &other) const
+        {
+            return network < other.network;
+        }
+    };
+
+    struct Level
+    {
+        int prefixLength;
+        QVector<Subnet> subnets;
+    };
+
+    struct Interface
+    {
+        QNetworkInterface networkInterface;
+        QList<QHostAddress> ipv4Addresses;
+        QList<QHostAddress> ipv6Addresses;
+    };
+
+    static bool toKey(const QHostAddress &address, Key &key, int &bits);
+    static Key mask(const Key &key, int prefixLength);
+
+    QElapsedTimer age;
+    QList<int> order;
+    QHash<int, Interface> entries;
+    QList<int> ipv4Multicast;
+    QList<int> ipv6Multicast;
+    QVector<Level> levels;
+    QVector<Key> localAddresses;
+};
+
+}
+
+#endif // QMDNSENGINE_ADDRESSTABLE_P_H
@@ -25,6 +25,7 @@
 #include <qmdnsengine/bitmap.h>
 
 #include "bitmap_p.h"
+#include "shareddata_p.h"
 
 using namespace QMdnsEngine;
 
@@ -34,6 +35,14 @@ BitmapPrivate::BitmapPrivate()
 {
 }
 
+BitmapPrivate::BitmapPrivate(const BitmapPrivate &other)
+    : QSharedData(other),
+      length(0),
+      data(nullptr)
+{
+    fromData(other.length, other.data);
+}
+
 BitmapPrivate::~BitmapPrivate()
 {
     free();
@@ -61,20 +70,33 @@ Bitmap::Bitmap()
 }
 
 Bitmap::Bitmap(const Bitmap &other)
-    : d(new BitmapPrivate)
+    : d(other.d)
 {
-    d->fromData(other.d->length, other.d->data);
 }
 
 Bitmap &Bitmap::operator=(const Bitmap &other)
 {
-    d->free();
-    d->fromData(other.d->length, other.d->data);
+    d = other.d;
+    return *this;
+}
+
+Bitmap::Bitmap(Bitmap &&other) noexcept
+    : d(sharedNull<BitmapPrivate>())
+{
+    d.swap(other.d);
+}
+
+Bitmap &Bitmap::operator=(Bitmap &&other) noexcept
+{
+    d.swap(other.d);
     return *this;
 }
 
-bool Bitmap::operator==(const Bitmap &other)
+bool Bitmap::operator==(const Bitmap &other) const
 {
+    if (d == other.d) {
+        return true;
+    }
     if (d->length != other.d->length) {
         return false;
     }
@@ -88,7 +110,6 @@ bool Bitmap::operator==(const Bitmap &other)
 
 Bitmap::~Bitmap()
 {
-    delete d;
 }
 
 quint8 Bitmap::length() const
@@ -25,16 +25,18 @@
 #ifndef QMDNSENGINE_BITMAP_P_H
 #define QMDNSENGINE_BITMAP_P_H
 
+#include <QSharedData>
 #include <QtGlobal>
 
 namespace QMdnsEngine
 {
 
-class BitmapPrivate
+class BitmapPrivate : public QSharedData
 {
 public:
 
     BitmapPrivate();
+    BitmapPrivate(const BitmapPrivate &other);
     virtual ~BitmapPrivate();
 
     void free();
@@ -32,23 +32,54 @@
 #include <qmdnsengine/record.h>
 
 #include "browser_p.h"
+#include "dispatcher_p.h"
+#include "refreshscheduler_p.h"
 
 using namespace QMdnsEngine;
 
+// Continuous queries begin a second apart and back off to once an hour, as
+// suggested in RFC 6762 (section 5.2)
+const int DefaultMinimumQueryInterval = 1000;
+const int DefaultMaximumQueryInterval = 60 * 60 * 1000;
+
 BrowserPrivate::BrowserPrivate(Browser *browser, AbstractServer *server, const QByteArray &type, Cache *existingCache)
     : QObject(browser),
       server(server),
       type(type),
       cache(existingCache ? existingCache : new Cache(this)),
+      minimumQueryInterval(DefaultMinimumQueryInterval),
+      maximumQueryInterval(DefaultMaximumQueryInterval),
+      queryInterval(DefaultMinimumQueryInterval),
       q(browser)
 {
-    connect(server, &AbstractServer::messageReceived, this, &BrowserPrivate::onMessageReceived);
-    connect(cache, &Cache::shouldQuery, this, &BrowserPrivate::onShouldQuery);
+    // Subscribe to the records of interest - A and AAAA records are matched
+    // by type since the hostnames become known while processing a message
+    Dispatcher *dispatcher = Dispatcher::instance(server);
+    dispatcher->addListener(this, Dispatcher::Responses, [this](const Message &message) {
+        onMessageReceived(message);
+    });
+    if (type == MdnsBrowseType) {
+        dispatcher->subscribe(this, QByteArray(), PTR);
+        dispatcher->subscribe(this, QByteArray(), SRV);
+        dispatcher->subscribe(this, QByteArray(), TXT);
+    } else {
+        dispatcher->subscribe(this, type, PTR);
+        dispatcher->subscribeSuffix(this, type, SRV);
+        dispatcher->subscribeSuffix(this, type, TXT);
+    }
+    dispatcher->subscribe(this, QByteArray(), A);
+    dispatcher->subscribe(this, QByteArray(), AAAA);
+
+    // Records in the cache are refreshed by the scheduler shared with any
+    // other browsers and resolvers using the cache
+    refreshScheduler = RefreshScheduler::instance(server, cache);
+    refreshScheduler->addConsumer(this);
+
     connect(cache, &Cache::recordExpired, this, &BrowserPrivate::onRecordExpired);
+    connect(server, &AbstractServer::interfacesChanged, this, &BrowserPrivate::onInterfacesChanged);
     connect(&queryTimer, &QTimer::timeout, this, &BrowserPrivate::onQueryTimeout);
     connect(&serviceTimer, &QTimer::timeout, this, &BrowserPrivate::onServiceTimeout);
 
-    queryTimer.setInterval(60 * 1000);
     queryTimer.setSingleShot(true);
 
     serviceTimer.setInterval(100);
@@ -187,22 +218,10 @@ void BrowserPrivate::onMessageReceived(const Message &message)
             queryMessage.addQuery(query);
         }
         server->sendMessageToAll(queryMessage);
+        statistics.add(Statistics::QueriesSent);
     }
 }
 
-void BrowserPrivate::onShouldQuery(const Record &record)
-{
-    // Assume that all messages in the cache are still in use (by the browser)
-    // and attempt to renew them immediately
-
-    Query query;
-    query.setName(record.name());
-    query.setType(record.type());
-    Message message;
-    message.addQuery(query);
-    server->sendMessageToAll(message);
-}
-
 void BrowserPrivate::onRecordExpired(const Record &record)
 {
     // If the SRV record has expired for a service, then it must be
@@ -235,18 +254,27 @@ void BrowserPrivate::onQueryTimeout()
     Message message;
     message.addQuery(query);
 
-    // TODO: including too many records could cause problems
-
-    // Include PTR records for the target that are already known
+    // Include PTR records for the target that are already known, with the
+    // TTL that remains (the server splits the known answers across packets
+    // if there are too many)
     QList<Record> records;
-    if (cache->lookupRecords(query.name(), PTR, records)) {
+    if (cache->lookupKnownAnswers(query.name(), PTR, records)) {
         for (const Record &record : qAsConst(records)) {
             message.addRecord(record);
         }
     }
 
     server->sendMessageToAll(message);
-    queryTimer.start();
+    statistics.add(Statistics::QueriesSent);
+    scheduleQuery();
+}
+
+void BrowserPrivate::onInterfacesChanged()
+{
+    // Services may be found on the networks that were just joined, so the
+    // sequence of queries begins again right away
+    queryInterval = minimumQueryInterval;
+    onQueryTimeout();
 }
 
 void BrowserPrivate::onServiceTimeout()
@@ -263,7 +291,7 @@ void BrowserPrivate::onServiceTimeout()
 
             // Include PTR records for the target that are already known
             QList<Record> records;
-            if (cache->lookupRecords(target, PTR, records)) {
+            if (cache->lookupKnownAnswers(target, PTR, records)) {
                 for (const Record &record : qAsConst(records)) {
                     message.addRecord(record);
                 }
@@ -271,10 +299,23 @@ void BrowserPrivate::onServiceTimeout()
         }
 
         server->sendMessageToAll(message);
+        statistics.add(Statistics::QueriesSent);
         ptrTargets.clear();
     }
 }
 
+void BrowserPrivate::restartQueries()
+{
+    queryInterval = minimumQueryInterval;
+    scheduleQuery();
+}
+
+void BrowserPrivate::scheduleQuery()
+{
+    queryTimer.start(queryInterval);
+    queryInterval = static_cast<int>(qMin<qint64>(static_cast<qint64>(queryInterval) * 2, maximumQueryInterval));
+}
+
 void BrowserPrivate::updateHostnames()
 {
     hostnames.clear();
@@ -289,3 +330,38 @@ Browser::Browser(AbstractServer *server, const QByteArray &type, Cache *cache, Q
       d(new BrowserPrivate(this, server, type, cache))
 {
 }
+
+int Browser::minimumQueryInterval() const
+{
+    return d->minimumQueryInterval;
+}
+
+void Browser::setMinimumQueryInterval(int minimumQueryInterval)
+{
+    d->minimumQueryInterval = qMax(1, minimumQueryInterval);
+    d->maximumQueryInterval = qMax(d->minimumQueryInterval, d->maximumQueryInterval);
+    d->restartQueries();
+}
+
+int Browser::maximumQueryInterval() const
+{
+    return d->maximumQueryInterval;
+}
+
+void Browser::setMaximumQueryInterval(int maximumQueryInterval)
+{
+    d->maximumQueryInterval = qMax(d->minimumQueryInterval, maximumQueryInterval);
+    d->restartQueries();
+}
+
+Statistics Browser::statistics() const
+{
+    Statistics statistics = d->statistics.snapshot();
+    if (d->cache->parent() == d) {
+        statistics += d->cache->statistics();
+        if (d->refreshScheduler) {
+            statistics += d->refreshScheduler->statistics();
+        }
+    }
+    return statistics;
+}
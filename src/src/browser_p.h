@@ -28,11 +28,14 @@
 #include <QByteArray>
 #include <QMap>
 #include <QObject>
+#include <QPointer>
 #include <QSet>
 #include <QTimer>
 
 #include <qmdnsengine/service.h>
 
+#include "statistics_p.h"
+
 namespace QMdnsEngine
 {
 
@@ -41,6 +44,7 @@ class Browser;
 class Cache;
 class Message;
 class Record;
+class RefreshScheduler;
 
 class BrowserPrivate : public QObject
 {
@@ -51,23 +55,34 @@ public:
     explicit BrowserPrivate(Browser *browser, AbstractServer *server, const QByteArray &type, Cache *existingCache);
 
     bool updateService(const QByteArray &fqName);
+    void restartQueries();
+    void scheduleQuery();
 
     AbstractServer *server;
     QByteArray type;
 
     Cache *cache;
+    QPointer<RefreshScheduler> refreshScheduler;
     QSet<QByteArray> ptrTargets;
     QMap<QByteArray, Service> services;
     QSet<QByteArray> hostnames;
 
+    // The interval between queries doubles after each query until it
+    // reaches the maximum
+    int minimumQueryInterval;
+    int maximumQueryInterval;
+    int queryInterval;
+
     QTimer queryTimer;
     QTimer serviceTimer;
 
+    StatisticsRecorder statistics;
+
 private Q_SLOTS:
 
     void onMessageReceived(const Message &message);
-    void onShouldQuery(const Record &record);
     void onRecordExpired(const Record &record);
+    void onInterfacesChanged();
 
     void onQueryTimeout();
     void onServiceTimeout();
@@ -22,6 +22,9 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <limits>
+
 #include <QtGlobal>
 #if(QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
 #include <QRandomGenerator>
@@ -35,59 +38,174 @@
 
 using namespace QMdnsEngine;
 
+// Refresh triggers fire at 50%, 85%, 90%, and 95% of the TTL; the record
+// expires once the final trigger (100%) is reached
+const int TriggerPermille[] = {500, 850, 900, 950, 1000};
+const int TriggerCount = sizeof(TriggerPermille) / sizeof(TriggerPermille[0]);
+
+// Order triggers so that the heap always has the earliest one at the front
+static bool laterTrigger(const CachePrivate::Trigger &a, const CachePrivate::Trigger &b)
+{
+    return a.time > b.time;
+}
+
 CachePrivate::CachePrivate(Cache *cache)
     : QObject(cache),
+      staleTriggers(0),
+      nextId(0),
+      nextTrigger(-1),
       q(cache)
 {
     connect(&timer, &QTimer::timeout, this, &CachePrivate::onTimeout);
 
     timer.setSingleShot(true);
+    clock.start();
+}
+
+void CachePrivate::insertEntry(const Entry &entry)
+{
+    // Add the entry to the bucket for its name and type, creating the bucket
+    // (and recording the type in the name index) if it does not exist yet
+    Key key(entry.record.name(), entry.record.type());
+    auto i = entries.find(key);
+    if (i == entries.end()) {
+        i = entries.insert(key, QList<Entry>());
+        types[key.first].append(key.second);
+    }
+    i.value().append(entry);
+    statistics.add(Statistics::CachedRecords);
+}
+
+CachePrivate::EntryHash::iterator CachePrivate::eraseKey(EntryHash::iterator i)
+{
+    // Remove the type from the name index before removing the bucket itself
+    auto j = types.find(i.key().first);
+    if (j != types.end()) {
+        j.value().removeOne(i.key().second);
+        if (j.value().isEmpty()) {
+            types.erase(j);
+        }
+    }
+    return entries.erase(i);
+}
+
+bool CachePrivate::appendRecords(const Key &key, QList<Record> &records) const
+{
+    auto i = entries.constFind(key);
+    if (i == entries.constEnd()) {
+        return false;
+    }
+    for (const Entry &entry : i.value()) {
+        records.append(entry.record);
+    }
+    return !i.value().isEmpty();
+}
+
+qint64 CachePrivate::triggerTime(const Entry &entry) const
+{
+    // The random offset is only applied to the refresh triggers so that the
+    // record still expires exactly when its TTL runs out
+    qint64 time = entry.added + static_cast<qint64>(entry.record.ttl()) * TriggerPermille[entry.trigger];
+    if (entry.trigger < TriggerCount - 1) {
+        time += entry.random;
+    }
+    return time;
+}
+
+void CachePrivate::scheduleTrigger(const Entry &entry, qint64 now)
+{
+    // Each entry has exactly one trigger in the heap - the next one due
+    Trigger trigger{triggerTime(entry), entry.id, Key(entry.record.name(), entry.record.type())};
+    triggers.append(trigger);
+    std::push_heap(triggers.begin(), triggers.end(), laterTrigger);
+
+    // Restart the timer if the new trigger is earlier than the next one
+    if (nextTrigger < 0 || trigger.time < nextTrigger) {
+        startTimer(now);
+    }
+}
+
+void CachePrivate::rebuildTriggers()
+{
+    // Triggers belonging to removed entries are left in the heap until they
+    // are due; once they make up most of the heap, rebuild it from the
+    // entries that remain
+    triggers.clear();
+    for (auto i = entries.constBegin(); i != entries.constEnd(); ++i) {
+        for (const Entry &entry : i.value()) {
+            triggers.append({triggerTime(entry), entry.id, i.key()});
+        }
+    }
+    std::make_heap(triggers.begin(), triggers.end(), laterTrigger);
+    staleTriggers = 0;
+}
+
+void CachePrivate::startTimer(qint64 now)
+{
+    if (triggers.isEmpty()) {
+        nextTrigger = -1;
+        timer.stop();
+        return;
+    }
+    nextTrigger = triggers.first().time;
+    timer.start(static_cast<int>(qBound<qint64>(0, nextTrigger - now, std::numeric_limits<int>::max())));
 }
 
 void CachePrivate::onTimeout()
 {
-    // Loop through all of the records in the cache, emitting the appropriate
-    // signal when a trigger has passed, determining when the next trigger
-    // will occur, and removing records that have expired
-    QDateTime now = QDateTime::currentDateTime();
-    QDateTime newNextTrigger;
-
-    for (auto i = entries.begin(); i != entries.end();) {
-
-        // Loop through the triggers and remove ones that have already
-        // passed
-        bool shouldQuery = false;
-        for (auto j = i->triggers.begin(); j != i->triggers.end();) {
-            if ((*j) <= now) {
-                shouldQuery = true;
-                j = i->triggers.erase(j);
-            } else {
-                break;
+    // Pop each trigger that is due from the heap, emitting the appropriate
+    // signal for its entry and scheduling the entry's next trigger; entries
+    // with no triggers due are never visited
+    const qint64 now = clock.elapsed();
+    while (!triggers.isEmpty() && triggers.first().time <= now) {
+        std::pop_heap(triggers.begin(), triggers.end(), laterTrigger);
+        const Trigger trigger = triggers.takeLast();
+
+        // If the entry no longer exists (it was replaced or removed), there
+        // is nothing left to do for the trigger
+        auto i = entries.find(trigger.key);
+        int index = -1;
+        if (i != entries.end()) {
+            for (int j = 0; j < i.value().count(); ++j) {
+                if (i.value().at(j).id == trigger.id) {
+                    index = j;
+                    break;
+                }
             }
         }
+        if (index == -1) {
+            --staleTriggers;
+            continue;
+        }
 
-        // If triggers remain, determine the next earliest one; if none
-        // remain, the record has expired and should be removed
-        if (i->triggers.length()) {
-            if (newNextTrigger.isNull() || i->triggers.at(0) < newNextTrigger) {
-                newNextTrigger = i->triggers.at(0);
-            }
-            if (shouldQuery) {
-                emit q->shouldQuery(i->record);
+        statistics.add(Statistics::TriggersFired);
+
+        // Skip over any later triggers that have also passed
+        QList<Entry> &bucket = i.value();
+        Entry &entry = bucket[index];
+        do {
+            ++entry.trigger;
+        } while (entry.trigger < TriggerCount && triggerTime(entry) <= now);
+
+        // If the final trigger was reached, the record has expired and is
+        // removed before announcing it; otherwise a query should be issued
+        if (entry.trigger == TriggerCount) {
+            Record record = bucket.takeAt(index).record;
+            if (bucket.isEmpty()) {
+                eraseKey(i);
             }
-            ++i;
+            statistics.subtract(Statistics::CachedRecords);
+            statistics.add(Statistics::RecordsExpired);
+            emit q->recordExpired(record);
         } else {
-            emit q->recordExpired(i->record);
-            i = entries.erase(i);
+            triggers.append({triggerTime(entry), entry.id, trigger.key});
+            std::push_heap(triggers.begin(), triggers.end(), laterTrigger);
+            Record record = entry.record;
+            emit q->shouldQuery(record);
         }
     }
 
-    // If newNextTrigger contains a value, it will be the time for the next
-    // trigger and the timer should be started again
-    nextTrigger = newNextTrigger;
-    if (!nextTrigger.isNull()) {
-        timer.start(now.msecsTo(nextTrigger));
-    }
+    startTimer(now);
 }
 
 Cache::Cache(QObject *parent)
@@ -99,54 +217,57 @@ Cache::Cache(QObject *parent)
 void Cache::addRecord(const Record &record)
 {
     // If a record exists that matches, remove it from the cache; if the TTL
-    // is nonzero, it will be added back to the cache with updated times
-    for (auto i = d->entries.begin(); i != d->entries.end();) {
-        if ((record.flushCache() &&
-                (*i).record.name() == record.name() &&
-                (*i).record.type() == record.type()) ||
-                (*i).record == record) {
-
-            // If the TTL is set to 0, indicate that the record was removed
-            if (record.ttl() == 0) {
-                emit recordExpired((*i).record);
-            }
+    // is nonzero, it will be added back to the cache with updated times -
+    // only records with the same name and type can match, so only that
+    // bucket needs to be examined
+    auto i = d->entries.find(CachePrivate::Key(record.name(), record.type()));
+    if (i != d->entries.end()) {
+        QList<CachePrivate::Entry> &bucket = i.value();
+        for (int j = 0; j < bucket.count();) {
+            if (record.flushCache() || bucket.at(j).record == record) {
 
-            i = d->entries.erase(i);
+                // The trigger for the removed entry remains in the heap
+                ++d->staleTriggers;
+                d->statistics.subtract(Statistics::CachedRecords);
 
-            // No need to continue further if the TTL was set to 0
-            if (record.ttl() == 0) {
-                return;
+                // If the TTL is set to 0, remove the record and indicate that
+                // it was removed - no need to continue further
+                if (record.ttl() == 0) {
+                    Record expiredRecord = bucket.takeAt(j).record;
+                    if (bucket.isEmpty()) {
+                        d->eraseKey(i);
+                    }
+                    emit recordExpired(expiredRecord);
+                    return;
+                }
+
+                bucket.removeAt(j);
+            } else {
+                ++j;
             }
-        } else {
-            ++i;
         }
     }
 
-    // Use the current time to calculate the triggers and add a random offset
-    QDateTime now = QDateTime::currentDateTime();
+    if (d->staleTriggers > 64 && d->staleTriggers > d->triggers.count() / 2) {
+        d->rebuildTriggers();
+    }
+
+    // Use the monotonic clock to timestamp the entry and add a random offset
+    // of up to 2% of the TTL to the refresh triggers (RFC 6762, section 5.2),
+    // which spreads out the queries for records received together
+    qint64 now = d->clock.elapsed();
+    const int jitter = static_cast<int>(qMin<qint64>(static_cast<qint64>(record.ttl()) * 20,
+            std::numeric_limits<int>::max() - 1)) + 1;
 #ifdef USE_QRANDOMGENERATOR
-    qint64 random = QRandomGenerator::global()->bounded(20);
+    qint64 random = QRandomGenerator::global()->bounded(jitter);
 #else
-    qint64 random = qrand() % 20;
+    qint64 random = qrand() % jitter;
 #endif
 
-    QList<QDateTime> triggers{
-        now.addMSecs(record.ttl() * 500 + random),  // 50%
-        now.addMSecs(record.ttl() * 850 + random),  // 85%
-        now.addMSecs(record.ttl() * 900 + random),  // 90%
-        now.addMSecs(record.ttl() * 950 + random),  // 95%
-        now.addSecs(record.ttl())
-    };
-
-    // Append the record and its triggers
-    d->entries.append({record, triggers});
-
-    // Check if the new record's first trigger is earlier than the next
-    // scheduled trigger; if so, restart the timer
-    if (d->nextTrigger.isNull() || triggers.at(0) < d->nextTrigger) {
-        d->nextTrigger = triggers.at(0);
-        d->timer.start(now.msecsTo(d->nextTrigger));
-    }
+    // Add the entry and schedule its first trigger
+    CachePrivate::Entry entry{record, d->nextId++, now, random, 0};
+    d->insertEntry(entry);
+    d->scheduleTrigger(entry, now);
 }
 
 bool Cache::lookupRecord(const QByteArray &name, quint16 type, Record &record) const
@@ -162,12 +283,55 @@ bool Cache::lookupRecord(const QByteArray &name, quint16 type, Record &record) c
 bool Cache::lookupRecords(const QByteArray &name, quint16 type, QList<Record> &records) const
 {
     bool recordsAdded = false;
-    for (const CachePrivate::Entry &entry : d->entries) {
-        if ((name.isNull() || entry.record.name() == name) &&
-                (type == ANY || entry.record.type() == type)) {
-            records.append(entry.record);
-            recordsAdded = true;
+    if (name.isNull()) {
+
+        // Without a name, every bucket of the requested type must be visited
+        for (auto i = d->entries.constBegin(); i != d->entries.constEnd(); ++i) {
+            if (type == ANY || i.key().second == type) {
+                recordsAdded |= d->appendRecords(i.key(), records);
+            }
+        }
+    } else if (type == ANY) {
+
+        // Use the name index to find each type stored for the name
+        const auto types = d->types.value(name);
+        for (quint16 t : types) {
+            recordsAdded |= d->appendRecords(CachePrivate::Key(name, t), records);
+        }
+    } else {
+        recordsAdded = d->appendRecords(CachePrivate::Key(name, type), records);
+    }
+    d->statistics.add(Statistics::CacheLookups);
+    d->statistics.add(recordsAdded ? Statistics::CacheHits : Statistics::CacheMisses);
+    return recordsAdded;
+}
+
+bool Cache::lookupKnownAnswers(const QByteArray &name, quint16 type, QList<Record> &records) const
+{
+    auto i = d->entries.constFind(CachePrivate::Key(name, type));
+    if (i == d->entries.constEnd()) {
+        return false;
+    }
+
+    // A known answer is only useful while at least half of its TTL remains,
+    // and is sent with the TTL that remains (RFC 6762, section 7.1)
+    const qint64 now = d->clock.elapsed();
+    bool recordsAdded = false;
+    for (const CachePrivate::Entry &entry : i.value()) {
+        const qint64 ttl = static_cast<qint64>(entry.record.ttl()) * 1000;
+        const qint64 remaining = entry.added + ttl - now;
+        if (remaining * 2 < ttl) {
+            continue;
         }
+        Record record = entry.record;
+        record.setTtl(static_cast<quint32>(remaining / 1000));
+        records.append(record);
+        recordsAdded = true;
     }
     return recordsAdded;
 }
+
+Statistics Cache::statistics() const
+{
+    return d->statistics.snapshot();
+}
@@ -25,13 +25,19 @@
 #ifndef QMDNSENGINE_CACHE_P_H
 #define QMDNSENGINE_CACHE_P_H
 
-#include <QDateTime>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QList>
 #include <QObject>
+#include <QPair>
 #include <QTimer>
+#include <QVector>
 
 #include <qmdnsengine/record.h>
 
+#include "statistics_p.h"
+
 namespace QMdnsEngine
 {
 
@@ -43,17 +49,46 @@ class CachePrivate : public QObject
 
 public:
 
+    typedef QPair<QByteArray, quint16> Key;
+
     struct Entry
     {
         Record record;
-        QList<QDateTime> triggers;
+        quint64 id;
+        qint64 added;
+        qint64 random;
+        int trigger;
+    };
+
+    struct Trigger
+    {
+        qint64 time;
+        quint64 id;
+        Key key;
     };
 
+    typedef QHash<Key, QList<Entry>> EntryHash;
+
     CachePrivate(Cache *cache);
 
+    void insertEntry(const Entry &entry);
+    EntryHash::iterator eraseKey(EntryHash::iterator i);
+    bool appendRecords(const Key &key, QList<Record> &records) const;
+
+    qint64 triggerTime(const Entry &entry) const;
+    void scheduleTrigger(const Entry &entry, qint64 now);
+    void rebuildTriggers();
+    void startTimer(qint64 now);
+
     QTimer timer;
-    QList<Entry> entries;
-    QDateTime nextTrigger;
+    QElapsedTimer clock;
+    EntryHash entries;
+    QHash<QByteArray, QList<quint16>> types;
+    QVector<Trigger> triggers;
+    int staleTriggers;
+    quint64 nextId;
+    qint64 nextTrigger;
+    StatisticsRecorder statistics;
 
 private Q_SLOTS:
 
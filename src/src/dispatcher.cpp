@@ -0,0 +1,268 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QPointer>
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+#include "dispatcher_p.h"
+
+using namespace QMdnsEngine;
+
+Dispatcher::Dispatcher(AbstractServer *server)
+    : QObject(server),
+      nextId(0)
+{
+    connect(server, &AbstractServer::messageReceived, this, &Dispatcher::onMessageReceived);
+}
+
+Dispatcher *Dispatcher::instance(AbstractServer *server)
+{
+    Dispatcher *dispatcher = server->findChild<Dispatcher*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!dispatcher) {
+        dispatcher = new Dispatcher(server);
+    }
+    return dispatcher;
+}
+
+void Dispatcher::addListener(QObject *listener, int directions, const Handler &handler)
+{
+    removeListener(listener);
+    listeners.insert(listener, {nextId++, directions, handler, QList<Subscription>()});
+    connect(listener, &QObject::destroyed, this, &Dispatcher::onListenerDestroyed);
+}
+
+void Dispatcher::removeListener(QObject *listener)
+{
+    if (listeners.contains(listener)) {
+        unsubscribeAll(listener);
+        listeners.remove(listener);
+        disconnect(listener, &QObject::destroyed, this, &Dispatcher::onListenerDestroyed);
+    }
+}
+
+void Dispatcher::subscribe(QObject *listener, const QByteArray &name, quint16 type)
+{
+    addSubscription(listener, {false, name, type});
+}
+
+void Dispatcher::subscribeSuffix(QObject *listener, const QByteArray &suffix, quint16 type)
+{
+    addSubscription(listener, {true, suffix, type});
+}
+
+void Dispatcher::unsubscribe(QObject *listener, const QByteArray &name, quint16 type)
+{
+    auto i = listeners.find(listener);
+    if (i == listeners.end()) {
+        return;
+    }
+    QList<Subscription> &subscriptions = i.value().subscriptions;
+    for (int j = 0; j < subscriptions.count(); ++j) {
+        const Subscription &subscription = subscriptions.at(j);
+        if (!subscription.suffix && subscription.name == name && subscription.type == type) {
+            removeSubscription(listener, subscription);
+            subscriptions.removeAt(j);
+            return;
+        }
+    }
+}
+
+void Dispatcher::unsubscribeAll(QObject *listener)
+{
+    auto i = listeners.find(listener);
+    if (i == listeners.end()) {
+        return;
+    }
+    const auto subscriptions = i.value().subscriptions;
+    for (const Subscription &subscription : subscriptions) {
+        removeSubscription(listener, subscription);
+    }
+    i.value().subscriptions.clear();
+}
+
+void Dispatcher::onMessageReceived(const Message &message)
+{
+    const int direction = message.isResponse() ? Responses : Queries;
+    const auto queries = message.queries();
+    const auto records = message.records();
+
+    // Collect the matching queries and records for each listener, ordered by
+    // when the listener was added
+    QMap<quint64, Matches> matches;
+    QVector<QObject*> matched;
+    if (direction == Queries) {
+        for (int i = 0; i < queries.count(); ++i) {
+            matched.clear();
+            match(queries.at(i).name(), queries.at(i).type(), matched);
+            for (QObject *listener : qAsConst(matched)) {
+                const Listener &l = *listeners.constFind(listener);
+                if (!(l.directions & direction)) {
+                    continue;
+                }
+                Matches &m = matches[l.id];
+                m.listener = listener;
+                if (m.queries.isEmpty() || m.queries.last() != i) {
+                    m.queries.append(i);
+                }
+            }
+        }
+    }
+    for (int i = 0; i < records.count(); ++i) {
+        matched.clear();
+        match(records.at(i).name(), records.at(i).type(), matched);
+        for (QObject *listener : qAsConst(matched)) {
+            const Listener &l = *listeners.constFind(listener);
+            if (!(l.directions & direction)) {
+                continue;
+            }
+
+            // Records in a query (known answers) are only of interest to
+            // listeners that matched one of the queries, unless they also
+            // want known answers sent without queries (in continuation
+            // packets of a truncated query)
+            auto j = matches.find(l.id);
+            if (j == matches.end()) {
+                if (direction == Queries && !(l.directions & KnownAnswers)) {
+                    continue;
+                }
+                j = matches.insert(l.id, {listener, QVector<int>(), QVector<int>()});
+            }
+            if (j.value().records.isEmpty() || j.value().records.last() != i) {
+                j.value().records.append(i);
+            }
+        }
+    }
+
+    // Deliver the trimmed message to each listener; listeners (or the
+    // dispatcher itself) may be removed by a handler, so each is looked up
+    // again before it is invoked
+    QPointer<Dispatcher> self(this);
+    for (auto i = matches.constBegin(); i != matches.constEnd(); ++i) {
+        auto l = listeners.constFind(i.value().listener);
+        if (l == listeners.constEnd() || l.value().id != i.key()) {
+            continue;
+        }
+        Message trimmed;
+        trimmed.setAddress(message.address());
+        trimmed.setPort(message.port());
+        trimmed.setInterfaceIndex(message.interfaceIndex());
+        trimmed.setTransactionId(message.transactionId());
+        trimmed.setResponse(message.isResponse());
+        trimmed.setTruncated(message.isTruncated());
+        for (int index : i.value().queries) {
+            trimmed.addQuery(queries.at(index));
+        }
+        for (int index : i.value().records) {
+            trimmed.addRecord(records.at(index));
+        }
+        Handler handler = l.value().handler;
+        handler(trimmed);
+        if (!self) {
+            return;
+        }
+    }
+}
+
+void Dispatcher::onListenerDestroyed(QObject *listener)
+{
+    removeListener(listener);
+}
+
+void Dispatcher::addSubscription(QObject *listener, const Subscription &subscription)
+{
+    auto i = listeners.find(listener);
+    if (i == listeners.end()) {
+        return;
+    }
+    QVector<QObject*> &indexed = index(subscription)[subscription.type];
+    if (!indexed.contains(listener)) {
+        indexed.append(listener);
+        i.value().subscriptions.append(subscription);
+    }
+}
+
+void Dispatcher::removeSubscription(QObject *listener, const Subscription &subscription)
+{
+    TypeIndex &typeIndex = index(subscription);
+    auto i = typeIndex.find(subscription.type);
+    if (i != typeIndex.end()) {
+        i.value().removeOne(listener);
+        if (i.value().isEmpty()) {
+            typeIndex.erase(i);
+        }
+    }
+
+    // Remove empty entries for names and suffixes so that they are no longer
+    // examined when matching
+    if (typeIndex.isEmpty() && !subscription.name.isNull()) {
+        if (subscription.suffix) {
+            suffixes.remove(subscription.name);
+        } else {
+            names.remove(subscription.name);
+        }
+    }
+}
+
+Dispatcher::TypeIndex &Dispatcher::index(const Subscription &subscription)
+{
+    if (subscription.name.isNull()) {
+        return anyName;
+    }
+    return subscription.suffix ? suffixes[subscription.name] : names[subscription.name];
+}
+
+void Dispatcher::match(const QByteArray &name, quint16 type, QVector<QObject*> &matched) const
+{
+    auto collect = [&](const TypeIndex &typeIndex) {
+        if (type == ANY) {
+            for (auto i = typeIndex.constBegin(); i != typeIndex.constEnd(); ++i) {
+                matched += i.value();
+            }
+        } else {
+            matched += typeIndex.value(type);
+            matched += typeIndex.value(ANY);
+        }
+    };
+
+    collect(anyName);
+    auto i = names.constFind(name);
+    if (i != names.constEnd()) {
+        collect(i.value());
+    }
+
+    // Look up each suffix of the name following a "." without copying it
+    if (!suffixes.isEmpty()) {
+        for (int j = name.indexOf('.'); j != -1 && j + 1 < name.length(); j = name.indexOf('.', j + 1)) {
+            auto k = suffixes.constFind(QByteArray::fromRawData(name.constData() + j + 1, name.length() - j - 1));
+            if (k != suffixes.constEnd()) {
+                collect(k.value());
+            }
+        }
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_DISPATCHER_P_H
+#define QMDNSENGINE_DISPATCHER_P_H
+
+#include <functional>
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QVector>
+
+namespace QMdnsEngine
+{
+
+class AbstractServer;
+class Message;
+
+// Each server has a single dispatcher that indexes listeners by record name
+// (or service type suffix) and type so that a received message is only
+// delivered to the listeners interested in it, trimmed down to the matching
+// queries and records
+class Dispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    enum Direction {
+        Queries = 0x1,
+        Responses = 0x2,
+        KnownAnswers = 0x4
+    };
+
+    typedef std::function<void(const Message &)> Handler;
+
+    static Dispatcher *instance(AbstractServer *server);
+
+    void addListener(QObject *listener, int directions, const Handler &handler);
+    void removeListener(QObject *listener);
+
+    void subscribe(QObject *listener, const QByteArray &name, quint16 type);
+    void subscribeSuffix(QObject *listener, const QByteArray &suffix, quint16 type);
+    void unsubscribe(QObject *listener, const QByteArray &name, quint16 type);
+    void unsubscribeAll(QObject *listener);
+
+private Q_SLOTS:
+
+    void onMessageReceived(const Message &message);
+    void onListenerDestroyed(QObject *listener);
+
+private:
+
+    struct Subscription
+    {
+        bool suffix;
+        QByteArray name;
+        quint16 type;
+    };
+
+    struct Listener
+    {
+        quint64 id;
+        int directions;
+        Handler handler;
+        QList<Subscription> subscriptions;
+    };
+
+    struct Matches
+    {
+        QObject *listener;
+        QVector<int> queries;
+        QVector<int> records;
+    };
+
+    typedef QHash<quint16, QVector<QObject*>> TypeIndex;
+
+    explicit Dispatcher(AbstractServer *server);
+
+    void addSubscription(QObject *listener, const Subscription &subscription);
+    void removeSubscription(QObject *listener, const Subscription &subscription);
+    TypeIndex &index(const Subscription &subscription);
+
+    void match(const QByteArray &name, quint16 type, QVector<QObject*> &matched) const;
+
+    QHash<QObject*, Listener> listeners;
+    quint64 nextId;
+
+    TypeIndex anyName;
+    QHash<QByteArray, TypeIndex> names;
+    QHash<QByteArray, TypeIndex> suffixes;
+};
+
+}
+
+#endif // QMDNSENGINE_DISPATCHER_P_H
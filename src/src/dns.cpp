@@ -22,6 +22,8 @@
  * IN THE SOFTWARE.
  */
 
+#include <limits>
+
 #include <QHostAddress>
 #include <QtEndian>
 
@@ -31,6 +33,8 @@
 #include <qmdnsengine/query.h>
 #include <qmdnsengine/record.h>
 
+#include "packetwriter_p.h"
+
 namespace QMdnsEngine
 {
 
@@ -337,26 +341,21 @@ bool fromPacket(const QByteArray &packet, Message &message)
 
 void toPacket(const Message &message, QByteArray &packet)
 {
-    quint16 offset = 0;
-    quint16 flags = (message.isResponse() ? 0x8400 : 0) |
-        (message.isTruncated() ? 0x200 : 0);
-    writeInteger<quint16>(packet, offset, message.transactionId());
-    writeInteger<quint16>(packet, offset, flags);
-    writeInteger<quint16>(packet, offset, message.queries().length());
-    writeInteger<quint16>(packet, offset, message.records().length());
-    writeInteger<quint16>(packet, offset, 0);
-    writeInteger<quint16>(packet, offset, 0);
-    QMap<QByteArray, quint16> nameMap;
-    const auto queries = message.queries();
-    for (const Query &query : queries) {
-        writeName(packet, offset, query.name(), nameMap);
-        writeInteger<quint16>(packet, offset, query.type());
-        writeInteger<quint16>(packet, offset, query.unicastResponse() ? 0x8001 : 1);
-    }
-    const auto records = message.records();
-    for (Record record : records) {
-        writeRecord(packet, offset, record, nameMap);
+    PacketWriter writer;
+    writer.start(message, std::numeric_limits<int>::max());
+    writer.writePacket();
+    packet.append(writer.data(), writer.size());
+}
+
+QList<QByteArray> toPackets(const Message &message, int maxSize)
+{
+    QList<QByteArray> packets;
+    PacketWriter writer;
+    writer.start(message, maxSize);
+    while (writer.writePacket()) {
+        packets.append(QByteArray(writer.data(), writer.size()));
     }
+    return packets;
 }
 
 QString typeName(quint16 type)
@@ -0,0 +1,130 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "duplicatefilter_p.h"
+
+using namespace QMdnsEngine;
+
+// Upper bound on the datagrams remembered, so that a flood of distinct
+// datagrams cannot grow the filter without limit
+const int MaxEntries = 1024;
+
+// Parameters of the 64-bit FNV-1a hash
+const quint64 FnvOffset = Q_UINT64_C(14695981039346656037);
+const quint64 FnvPrime = Q_UINT64_C(1099511628211);
+
+static quint64 fnv1a(quint64 hash, const uchar *data, int length)
+{
+    for (int i = 0; i < length; ++i) {
+        hash = (hash ^ data[i]) * FnvPrime;
+    }
+    return hash;
+}
+
+DuplicateFilter::DuplicateFilter()
+{
+    clock.start();
+}
+
+bool DuplicateFilter::isDuplicate(const QByteArray &packet, const QHostAddress &address,
+        quint16 port, bool ignoreSource, int window)
+{
+    const qint64 now = clock.elapsed();
+    expire(now, window);
+
+    // A datagram seen within the window is a duplicate; the time of the
+    // first copy is kept so that a steady stream of copies still expires
+    const quint64 hash = hashPacket(packet.constData(), packet.length(), address, port, ignoreSource);
+    if (times.contains(hash)) {
+        return true;
+    }
+    insertHash(hash, now);
+    return false;
+}
+
+void DuplicateFilter::insert(const char *data, int length, int window)
+{
+    // Unlike received datagrams, the time of the latest copy is kept, since
+    // the same packet may be sent again before the window ends
+    const qint64 now = clock.elapsed();
+    expire(now, window);
+    insertHash(hashPacket(data, length, QHostAddress(), 0, true), now);
+}
+
+bool DuplicateFilter::contains(const QByteArray &packet, int window)
+{
+    expire(clock.elapsed(), window);
+    return times.contains(hashPacket(packet.constData(), packet.length(), QHostAddress(), 0, true));
+}
+
+void DuplicateFilter::clear()
+{
+    times.clear();
+    entries.clear();
+}
+
+quint64 DuplicateFilter::hashPacket(const char *data, int length, const QHostAddress &address,
+        quint16 port, bool ignoreSource)
+{
+    quint64 hash = fnv1a(FnvOffset, reinterpret_cast<const uchar*>(data), length);
+    if (!ignoreSource) {
+        if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+            const quint32 ipv4Addr = address.toIPv4Address();
+            hash = fnv1a(hash, reinterpret_cast<const uchar*>(&ipv4Addr), sizeof(quint32));
+        } else {
+            const Q_IPV6ADDR ipv6Addr = address.toIPv6Address();
+            hash = fnv1a(hash, ipv6Addr.c, sizeof(Q_IPV6ADDR));
+        }
+        hash = fnv1a(hash, reinterpret_cast<const uchar*>(&port), sizeof(quint16));
+    }
+    return hash;
+}
+
+void DuplicateFilter::insertHash(quint64 hash, qint64 now)
+{
+    if (entries.count() >= MaxEntries) {
+        removeEntry(entries.dequeue());
+    }
+    times.insert(hash, now);
+    entries.enqueue({hash, now});
+}
+
+void DuplicateFilter::removeEntry(const Entry &entry)
+{
+    // A hash inserted again has a later entry in the queue, which is left
+    // to remove it
+    auto i = times.find(entry.hash);
+    if (i != times.end() && i.value() == entry.time) {
+        times.erase(i);
+    }
+}
+
+void DuplicateFilter::expire(qint64 now, int window)
+{
+    // Entries are queued in the order they were seen, so only the front of
+    // the queue needs to be checked
+    while (!entries.isEmpty() && now - entries.head().time >= window) {
+        removeEntry(entries.dequeue());
+    }
+}
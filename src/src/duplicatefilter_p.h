@@ -0,0 +1,77 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_DUPLICATEFILTER_P_H
+#define QMDNSENGINE_DUPLICATEFILTER_P_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QQueue>
+
+namespace QMdnsEngine
+{
+
+// Remembers the datagrams received during a short window so that copies of
+// the same datagram - arriving on both sockets or on several interfaces - can
+// be dropped before they are decoded; datagrams are identified by a 64-bit
+// hash of the payload and, unless ignored, the source address and port - the
+// same filter also remembers the packets sent, to recognise them when they
+// are looped back
+class DuplicateFilter
+{
+public:
+
+    DuplicateFilter();
+
+    bool isDuplicate(const QByteArray &packet, const QHostAddress &address, quint16 port,
+            bool ignoreSource, int window);
+    void insert(const char *data, int length, int window);
+    bool contains(const QByteArray &packet, int window);
+    void clear();
+
+private:
+
+    struct Entry
+    {
+        quint64 hash;
+        qint64 time;
+    };
+
+    static quint64 hashPacket(const char *data, int length, const QHostAddress &address,
+            quint16 port, bool ignoreSource);
+
+    void insertHash(quint64 hash, qint64 now);
+    void removeEntry(const Entry &entry);
+    void expire(qint64 now, int window);
+
+    QElapsedTimer clock;
+    QHash<quint64, qint64> times;
+    QQueue<Entry> entries;
+};
+
+}
+
+#endif // QMDNSENGINE_DUPLICATEFILTER_P_H
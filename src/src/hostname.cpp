@@ -24,8 +24,6 @@
 
 #include <QHostAddress>
 #include <QHostInfo>
-#include <QNetworkAddressEntry>
-#include <QNetworkInterface>
 
 #include <qmdnsengine/abstractserver.h>
 #include <qmdnsengine/dns.h>
@@ -34,16 +32,24 @@
 #include <qmdnsengine/query.h>
 #include <qmdnsengine/record.h>
 
+#include "addresstable_p.h"
+#include "dispatcher_p.h"
 #include "hostname_p.h"
+#include "responder_p.h"
 
 using namespace QMdnsEngine;
 
 HostnamePrivate::HostnamePrivate(Hostname *hostname, AbstractServer *server)
     : QObject(hostname),
       server(server),
+      dispatcher(Dispatcher::instance(server)),
+      responder(Responder::instance(server)),
       q(hostname)
 {
-    connect(server, &AbstractServer::messageReceived, this, &HostnamePrivate::onMessageReceived);
+    dispatcher->addListener(this, Dispatcher::Queries | Dispatcher::Responses, [this](const Message &message) {
+        onMessageReceived(message);
+    });
+    connect(server, &AbstractServer::interfacesChanged, this, &HostnamePrivate::onInterfacesChanged);
     connect(&registrationTimer, &QTimer::timeout, this, &HostnamePrivate::onRegistrationTimeout);
     connect(&rebroadcastTimer, &QTimer::timeout, this, &HostnamePrivate::onRebroadcastTimeout);
 
@@ -69,6 +75,11 @@ void HostnamePrivate::assertHostname()
     hostname = (hostnameSuffix == 1 ? localHostname:
         localHostname + "-" + QByteArray::number(hostnameSuffix)) + ".local.";
 
+    // Both queries for the hostname and conflicting responses are of interest
+    dispatcher->unsubscribeAll(this);
+    dispatcher->subscribe(this, hostname, A);
+    dispatcher->subscribe(this, hostname, AAAA);
+
     // Compose a query for A and AAAA records matching the hostname
     Query ipv4Query;
     ipv4Query.setName(hostname);
@@ -86,30 +97,26 @@ void HostnamePrivate::assertHostname()
     registrationTimer.start();
 }
 
-bool HostnamePrivate::generateRecord(const QHostAddress &srcAddress, quint16 type, Record &record)
+bool HostnamePrivate::generateRecord(const Message &message, quint16 type, Record &record)
 {
-    // Attempt to find the interface that corresponds with the provided
-    // address and determine this device's address from the interface
-
-    const auto interfaces = QNetworkInterface::allInterfaces();
-    for (const QNetworkInterface &networkInterface : interfaces) {
-        const auto entries = networkInterface.addressEntries();
-        for (const QNetworkAddressEntry &entry : entries) {
-            if (srcAddress.isInSubnet(entry.ip(), entry.prefixLength())) {
-                for (const QNetworkAddressEntry &newEntry : entries) {
-                    QHostAddress address = newEntry.ip();
-                    if ((address.protocol() == QAbstractSocket::IPv4Protocol && type == A) ||
-                            (address.protocol() == QAbstractSocket::IPv6Protocol && type == AAAA)) {
-                        record.setName(hostname);
-                        record.setType(type);
-                        record.setAddress(address);
-                        return true;
-                    }
-                }
-            }
-        }
+    // Determine this device's address from the interface that the query
+    // arrived on or, if that is not known, the interface on the same subnet
+    // as the address that sent it
+
+    const auto table = AddressTable::current();
+    int interfaceIndex = message.interfaceIndex();
+    if (!interfaceIndex) {
+        interfaceIndex = table->interfaceIndex(message.address());
+    }
+    QHostAddress address = table->localAddress(interfaceIndex, type == A ?
+        QAbstractSocket::IPv4Protocol : QAbstractSocket::IPv6Protocol);
+    if (address.isNull()) {
+        return false;
     }
-    return false;
+    record.setName(hostname);
+    record.setType(type);
+    record.setAddress(address);
+    return true;
 }
 
 void HostnamePrivate::onMessageReceived(const Message &message)
@@ -129,20 +136,27 @@ void HostnamePrivate::onMessageReceived(const Message &message)
         if (!hostnameRegistered) {
             return;
         }
-        Message reply;
-        reply.reply(message);
+        QList<Record> records;
         const auto queries = message.queries();
         for (const Query &query : queries) {
             if ((query.type() == A || query.type() == AAAA) && query.name() == hostname) {
                 Record record;
-                if (generateRecord(message.address(), query.type(), record)) {
-                    reply.addRecord(record);
+                if (generateRecord(message, query.type(), record)) {
+                    records.append(record);
                 }
             }
         }
-        if (reply.records().count()) {
-            server->sendMessage(reply);
-        }
+        responder->respond(message, records);
+    }
+}
+
+void HostnamePrivate::onInterfacesChanged()
+{
+    // The hostname may not be unique on the networks that were joined, so it
+    // is asserted again right away rather than at the next rebroadcast
+    if (hostnameRegistered) {
+        rebroadcastTimer.stop();
+        onRebroadcastTimeout();
     }
 }
 
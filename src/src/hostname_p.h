@@ -28,15 +28,15 @@
 #include <QObject>
 #include <QTimer>
 
-class QHostAddress;
-
 namespace QMdnsEngine
 {
 
 class AbstractServer;
+class Dispatcher;
 class Hostname;
 class Message;
 class Record;
+class Responder;
 
 class HostnamePrivate : public QObject
 {
@@ -47,9 +47,11 @@ public:
     HostnamePrivate(Hostname *hostname, AbstractServer *server);
 
     void assertHostname();
-    bool generateRecord(const QHostAddress &srcAddress, quint16 type, Record &record);
+    bool generateRecord(const Message &message, quint16 type, Record &record);
 
     AbstractServer *server;
+    Dispatcher *dispatcher;
+    Responder *responder;
 
     QByteArray hostnamePrev;
     QByteArray hostname;
@@ -62,6 +64,7 @@ public:
 private Q_SLOTS:
 
     void onMessageReceived(const Message &message);
+    void onInterfacesChanged();
     void onRegistrationTimeout();
     void onRebroadcastTimeout();
 
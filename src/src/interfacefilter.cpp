@@ -0,0 +1,188 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QNetworkInterface>
+
+#include <qmdnsengine/interfacefilter.h>
+
+#include "interfacefilter_p.h"
+#include "shareddata_p.h"
+
+using namespace QMdnsEngine;
+
+// Match a name against a pattern with "*" and "?" wildcards; after a
+// mismatch, the most recent "*" is retried with one more character
+static bool matchPattern(const QString &pattern, const QString &name)
+{
+    int p = 0;
+    int n = 0;
+    int star = -1;
+    int starName = 0;
+    while (n < name.length()) {
+        if (p < pattern.length() && (pattern.at(p) == QLatin1Char('?') || pattern.at(p) == name.at(n))) {
+            ++p;
+            ++n;
+        } else if (p < pattern.length() && pattern.at(p) == QLatin1Char('*')) {
+            star = p++;
+            starName = n;
+        } else if (star != -1) {
+            p = star + 1;
+            n = ++starName;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.length() && pattern.at(p) == QLatin1Char('*')) {
+        ++p;
+    }
+    return p == pattern.length();
+}
+
+static bool matchAny(const QStringList &patterns, const QString &name)
+{
+    for (const QString &pattern : patterns) {
+        if (matchPattern(pattern, name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+InterfaceFilterPrivate::InterfaceFilterPrivate()
+    : protocol(QAbstractSocket::AnyIPProtocol)
+{
+}
+
+InterfaceFilter::InterfaceFilter()
+    : d(new InterfaceFilterPrivate)
+{
+}
+
+InterfaceFilter::InterfaceFilter(const InterfaceFilter &other)
+    : d(other.d)
+{
+}
+
+InterfaceFilter &InterfaceFilter::operator=(const InterfaceFilter &other)
+{
+    d = other.d;
+    return *this;
+}
+
+InterfaceFilter::InterfaceFilter(InterfaceFilter &&other) noexcept
+    : d(sharedNull<InterfaceFilterPrivate>())
+{
+    d.swap(other.d);
+}
+
+InterfaceFilter &InterfaceFilter::operator=(InterfaceFilter &&other) noexcept
+{
+    d.swap(other.d);
+    return *this;
+}
+
+InterfaceFilter::~InterfaceFilter()
+{
+}
+
+QStringList InterfaceFilter::allowedNames() const
+{
+    return d->allowedNames;
+}
+
+void InterfaceFilter::setAllowedNames(const QStringList &allowedNames)
+{
+    d->allowedNames = allowedNames;
+}
+
+QStringList InterfaceFilter::deniedNames() const
+{
+    return d->deniedNames;
+}
+
+void InterfaceFilter::setDeniedNames(const QStringList &deniedNames)
+{
+    d->deniedNames = deniedNames;
+}
+
+QList<int> InterfaceFilter::allowedIndexes() const
+{
+    return d->allowedIndexes;
+}
+
+void InterfaceFilter::setAllowedIndexes(const QList<int> &allowedIndexes)
+{
+    d->allowedIndexes = allowedIndexes;
+}
+
+QList<int> InterfaceFilter::deniedIndexes() const
+{
+    return d->deniedIndexes;
+}
+
+void InterfaceFilter::setDeniedIndexes(const QList<int> &deniedIndexes)
+{
+    d->deniedIndexes = deniedIndexes;
+}
+
+QAbstractSocket::NetworkLayerProtocol InterfaceFilter::protocol() const
+{
+    return d->protocol;
+}
+
+void InterfaceFilter::setProtocol(QAbstractSocket::NetworkLayerProtocol protocol)
+{
+    d->protocol = protocol;
+}
+
+InterfaceFilter::Predicate InterfaceFilter::predicate() const
+{
+    return d->predicate;
+}
+
+void InterfaceFilter::setPredicate(const Predicate &predicate)
+{
+    d->predicate = predicate;
+}
+
+bool InterfaceFilter::acceptsProtocol(QAbstractSocket::NetworkLayerProtocol protocol) const
+{
+    return d->protocol == QAbstractSocket::AnyIPProtocol || d->protocol == protocol;
+}
+
+bool InterfaceFilter::acceptsInterface(const QNetworkInterface &networkInterface) const
+{
+    // Denied interfaces are excluded first; if anything is allowed
+    // explicitly, the interface must be one of those
+    const QString name = networkInterface.name();
+    const int index = networkInterface.index();
+    if (d->deniedIndexes.contains(index) || matchAny(d->deniedNames, name)) {
+        return false;
+    }
+    if ((!d->allowedNames.isEmpty() || !d->allowedIndexes.isEmpty()) &&
+            !d->allowedIndexes.contains(index) && !matchAny(d->allowedNames, name)) {
+        return false;
+    }
+    return !d->predicate || d->predicate(networkInterface);
+}
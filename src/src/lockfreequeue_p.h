@@ -0,0 +1,101 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_LOCKFREEQUEUE_P_H
+#define QMDNSENGINE_LOCKFREEQUEUE_P_H
+
+#include <QAtomicPointer>
+#include <QVector>
+
+namespace QMdnsEngine
+{
+
+// Queue for handing values from any number of threads to a single consumer
+// without a lock; producers push onto a linked stack and the consumer takes
+// the whole stack at once, reversing it to restore the order of the values
+template<class T>
+class LockFreeQueue
+{
+public:
+
+    LockFreeQueue() : head(nullptr) {}
+    ~LockFreeQueue();
+
+    bool push(const T &value);
+    QVector<T> takeAll();
+
+private:
+
+    struct Node
+    {
+        T value;
+        Node *next;
+    };
+
+    Q_DISABLE_COPY(LockFreeQueue)
+
+    QAtomicPointer<Node> head;
+};
+
+template<class T>
+LockFreeQueue<T>::~LockFreeQueue()
+{
+    takeAll();
+}
+
+// Returns true if the queue was empty, in which case the consumer must be
+// notified that values are waiting
+template<class T>
+bool LockFreeQueue<T>::push(const T &value)
+{
+    Node *node = new Node{value, nullptr};
+    Node *next;
+    do {
+        next = head.loadAcquire();
+        node->next = next;
+    } while (!head.testAndSetRelease(next, node));
+    return !next;
+}
+
+template<class T>
+QVector<T> LockFreeQueue<T>::takeAll()
+{
+    Node *node = head.fetchAndStoreAcquire(nullptr);
+    int count = 0;
+    for (Node *i = node; i; i = i->next) {
+        ++count;
+    }
+    QVector<T> values(count);
+    while (node) {
+        values[--count] = node->value;
+        Node *next = node->next;
+        delete node;
+        node = next;
+    }
+    return values;
+}
+
+}
+
+#endif // QMDNSENGINE_LOCKFREEQUEUE_P_H
@@ -31,5 +31,6 @@ const quint16 MdnsPort = 5353;
 const QHostAddress MdnsIpv4Address("224.0.0.251");
 const QHostAddress MdnsIpv6Address("ff02::fb");
 const QByteArray MdnsBrowseType("_services._dns-sd._udp.local.");
+const int MdnsMaxPacketSize = 1460;
 
 }
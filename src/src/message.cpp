@@ -28,11 +28,13 @@
 #include <qmdnsengine/record.h>
 
 #include "message_p.h"
+#include "shareddata_p.h"
 
 using namespace QMdnsEngine;
 
 MessagePrivate::MessagePrivate()
     : port(0),
+      interfaceIndex(0),
       transactionId(0),
       isResponse(false),
       isTruncated(false)
@@ -45,20 +47,30 @@ Message::Message()
 }
 
 Message::Message(const Message &other)
-    : d(new MessagePrivate)
+    : d(other.d)
 {
-    *this = other;
 }
 
 Message &Message::operator=(const Message &other)
 {
-    *d = *other.d;
+    d = other.d;
+    return *this;
+}
+
+Message::Message(Message &&other) noexcept
+    : d(sharedNull<MessagePrivate>())
+{
+    d.swap(other.d);
+}
+
+Message &Message::operator=(Message &&other) noexcept
+{
+    d.swap(other.d);
     return *this;
 }
 
 Message::~Message()
 {
-    delete d;
 }
 
 QHostAddress Message::address() const
@@ -81,6 +93,16 @@ void Message::setPort(quint16 port)
     d->port = port;
 }
 
+int Message::interfaceIndex() const
+{
+    return d->interfaceIndex;
+}
+
+void Message::setInterfaceIndex(int interfaceIndex)
+{
+    d->interfaceIndex = interfaceIndex;
+}
+
 quint16 Message::transactionId() const
 {
     return d->transactionId;
@@ -143,6 +165,7 @@ void Message::reply(const Message &other)
         setAddress(other.address());
     }
     setPort(other.port());
+    setInterfaceIndex(other.interfaceIndex());
     setTransactionId(other.transactionId());
     setResponse(true);
 }
@@ -27,6 +27,7 @@
 
 #include <QHostAddress>
 #include <QList>
+#include <QSharedData>
 
 namespace QMdnsEngine
 {
@@ -34,7 +35,7 @@ namespace QMdnsEngine
 class Query;
 class Record;
 
-class MessagePrivate
+class MessagePrivate : public QSharedData
 {
 public:
 
@@ -42,6 +43,7 @@ public:
 
     QHostAddress address;
     quint16 port;
+    int interfaceIndex;
     quint16 transactionId;
     bool isResponse;
     bool isTruncated;
@@ -0,0 +1,248 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/messageview.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+#include "messageview_p.h"
+
+using namespace QMdnsEngine;
+
+MessageViewPrivate::MessageViewPrivate()
+    : transactionId(0),
+      flags(0)
+{
+}
+
+bool MessageViewPrivate::skipName(quint16 &offset) const
+{
+    return walkName(offset, [](const char *, int) {
+        return true;
+    });
+}
+
+bool MessageViewPrivate::parseDataName(const RecordEntry &entry, quint16 &offset,
+        QByteArray &name) const
+{
+    // The labels of a name in the record data may point elsewhere in the
+    // packet, but the name itself must end within the data
+    return offset < entry.dataOffset + entry.dataLength &&
+            parseName(packet, offset, name) &&
+            offset <= entry.dataOffset + entry.dataLength;
+}
+
+bool MessageViewPrivate::nameEquals(quint16 offset, const QByteArray &name) const
+{
+    // Each label must match the next part of the name and be followed by a
+    // "." in the name, exactly as parseName() would have produced it
+    int position = 0;
+    bool matched = walkName(offset, [&](const char *label, int length) {
+        if (position + length >= name.length() ||
+                memcmp(name.constData() + position, label, length) != 0 ||
+                name.at(position + length) != '.') {
+            return false;
+        }
+        position += length + 1;
+        return true;
+    });
+    return matched && position == name.length();
+}
+
+bool MessageViewPrivate::nameEndsWith(quint16 offset, const QByteArray &suffix) const
+{
+    // Determine the length of the decoded name so that the position where
+    // the suffix would begin is known
+    int length = 0;
+    quint16 lengthOffset = offset;
+    if (!walkName(lengthOffset, [&](const char *, int labelLength) {
+        length += labelLength + 1;
+        return true;
+    })) {
+        return false;
+    }
+    int start = length - suffix.length();
+    if (start < 0) {
+        return false;
+    }
+
+    // Compare each character of the decoded name from that position onward
+    int position = 0;
+    return walkName(offset, [&](const char *label, int labelLength) {
+        for (int i = 0; i <= labelLength; ++i, ++position) {
+            if (position >= start &&
+                    suffix.at(position - start) != (i < labelLength ? label[i] : '.')) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+MessageView::MessageView()
+    : d(new MessageViewPrivate)
+{
+}
+
+MessageView::MessageView(const MessageView &other)
+    : d(other.d)
+{
+}
+
+MessageView &MessageView::operator=(const MessageView &other)
+{
+    d = other.d;
+    return *this;
+}
+
+MessageView::~MessageView()
+{
+}
+
+bool MessageView::parse(const QByteArray &packet)
+{
+    // The index is reused unless it is shared with copies or with query and
+    // record views, which keep referring to the previous packet
+    if (d->ref.loadAcquire() != 1) {
+        d = new MessageViewPrivate;
+    }
+    d->packet = packet;
+    d->queries.clear();
+    d->records.clear();
+
+    quint16 offset = 0;
+    quint16 nQuestion, nAnswer, nAuthority, nAdditional;
+    if (!d->readInteger<quint16>(offset, d->transactionId) ||
+            !d->readInteger<quint16>(offset, d->flags) ||
+            !d->readInteger<quint16>(offset, nQuestion) ||
+            !d->readInteger<quint16>(offset, nAnswer) ||
+            !d->readInteger<quint16>(offset, nAuthority) ||
+            !d->readInteger<quint16>(offset, nAdditional)) {
+        return false;
+    }
+
+    // Record the location of each query, skipping over its name
+    d->queries.reserve(nQuestion);
+    for (int i = 0; i < nQuestion; ++i) {
+        MessageViewPrivate::QueryEntry entry;
+        entry.nameOffset = offset;
+        if (!d->skipName(offset) ||
+                !d->readInteger<quint16>(offset, entry.type) ||
+                !d->readInteger<quint16>(offset, entry.class_)) {
+            d->queries.clear();
+            return false;
+        }
+        d->queries.append(entry);
+    }
+
+    // Record the location of each record and its data, skipping over the
+    // data itself
+    int nRecord = nAnswer + nAuthority + nAdditional;
+    d->records.reserve(nRecord);
+    for (int i = 0; i < nRecord; ++i) {
+        MessageViewPrivate::RecordEntry entry;
+        entry.nameOffset = offset;
+        if (!d->skipName(offset) ||
+                !d->readInteger<quint16>(offset, entry.type) ||
+                !d->readInteger<quint16>(offset, entry.class_) ||
+                !d->readInteger<quint32>(offset, entry.ttl) ||
+                !d->readInteger<quint16>(offset, entry.dataLength) ||
+                offset + entry.dataLength > d->packet.length()) {
+            d->queries.clear();
+            d->records.clear();
+            return false;
+        }
+        entry.dataOffset = offset;
+        offset += entry.dataLength;
+        d->records.append(entry);
+    }
+
+    return true;
+}
+
+QByteArray MessageView::packet() const
+{
+    return d->packet;
+}
+
+quint16 MessageView::transactionId() const
+{
+    return d->transactionId;
+}
+
+bool MessageView::isResponse() const
+{
+    return d->flags & 0x8400;
+}
+
+bool MessageView::isTruncated() const
+{
+    return d->flags & 0x0200;
+}
+
+int MessageView::queryCount() const
+{
+    return d->queries.count();
+}
+
+QueryView MessageView::query(int index) const
+{
+    return QueryView(d, index);
+}
+
+int MessageView::recordCount() const
+{
+    return d->records.count();
+}
+
+RecordView MessageView::record(int index) const
+{
+    return RecordView(d, index);
+}
+
+bool MessageView::toMessage(Message &message) const
+{
+    message.setTransactionId(transactionId());
+    message.setResponse(isResponse());
+    message.setTruncated(isTruncated());
+    for (int i = 0; i < d->queries.count(); ++i) {
+        Query query;
+        if (!QueryView(d, i).toQuery(query)) {
+            return false;
+        }
+        message.addQuery(query);
+    }
+    for (int i = 0; i < d->records.count(); ++i) {
+        Record record;
+        if (!RecordView(d, i).toRecord(record)) {
+            return false;
+        }
+        message.addRecord(record);
+    }
+    return true;
+}
@@ -0,0 +1,158 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_MESSAGEVIEW_P_H
+#define QMDNSENGINE_MESSAGEVIEW_P_H
+
+#include <QByteArray>
+#include <QSharedData>
+#include <QVector>
+#include <QtEndian>
+
+namespace QMdnsEngine
+{
+
+class MessageViewPrivate : public QSharedData
+{
+public:
+
+    struct QueryEntry
+    {
+        quint16 nameOffset;
+        quint16 type;
+        quint16 class_;
+    };
+
+    struct RecordEntry
+    {
+        quint16 nameOffset;
+        quint16 type;
+        quint16 class_;
+        quint32 ttl;
+        quint16 dataOffset;
+        quint16 dataLength;
+    };
+
+    MessageViewPrivate();
+
+    template<class T>
+    bool readInteger(quint16 &offset, T &value) const;
+
+    template<class T>
+    bool readData(const RecordEntry &entry, quint16 &offset, T &value) const;
+
+    template<class F>
+    bool walkName(quint16 &offset, F callback) const;
+
+    bool skipName(quint16 &offset) const;
+    bool parseDataName(const RecordEntry &entry, quint16 &offset, QByteArray &name) const;
+    bool nameEquals(quint16 offset, const QByteArray &name) const;
+    bool nameEndsWith(quint16 offset, const QByteArray &suffix) const;
+
+    QByteArray packet;
+    quint16 transactionId;
+    quint16 flags;
+    QVector<QueryEntry> queries;
+    QVector<RecordEntry> records;
+};
+
+template<class T>
+bool MessageViewPrivate::readInteger(quint16 &offset, T &value) const
+{
+    if (offset + sizeof(T) > static_cast<unsigned int>(packet.length())) {
+        return false;  // out-of-bounds
+    }
+    value = qFromBigEndian<T>(reinterpret_cast<const uchar*>(packet.constData() + offset));
+    offset += sizeof(T);
+    return true;
+}
+
+// Values in the data of a record must end within it, or they would be read
+// from the record that follows
+template<class T>
+bool MessageViewPrivate::readData(const RecordEntry &entry, quint16 &offset, T &value) const
+{
+    if (offset + sizeof(T) > static_cast<unsigned int>(entry.dataOffset + entry.dataLength)) {
+        return false;  // out-of-bounds
+    }
+    return readInteger<T>(offset, value);
+}
+
+template<class F>
+bool MessageViewPrivate::walkName(quint16 &offset, F callback) const
+{
+    // Follow the labels (and pointers) in the same way as parseName(), but
+    // hand each label to the callback instead of building the name; the
+    // callback returns false to stop early
+    quint16 offsetEnd = 0;
+    quint16 offsetPtr = offset;
+    forever {
+        quint8 nBytes;
+        if (!readInteger<quint8>(offset, nBytes)) {
+            return false;
+        }
+        if (!nBytes) {
+            break;
+        }
+        switch (nBytes & 0xc0) {
+        case 0x00:
+            if (offset + nBytes > packet.length()) {
+                return false;  // length exceeds message
+            }
+            if (!callback(packet.constData() + offset, nBytes)) {
+                return false;
+            }
+            offset += nBytes;
+            break;
+        case 0xc0:
+        {
+            quint8 nBytes2;
+            quint16 newOffset;
+            if (!readInteger<quint8>(offset, nBytes2)) {
+                return false;
+            }
+            newOffset = ((nBytes & ~0xc0) << 8) | nBytes2;
+            if (newOffset >= offsetPtr) {
+                return false;  // prevent infinite loop
+            }
+            offsetPtr = newOffset;
+            if (!offsetEnd) {
+                offsetEnd = offset;
+            }
+            offset = newOffset;
+            break;
+        }
+        default:
+            return false;  // no other types supported
+        }
+    }
+    if (offsetEnd) {
+        offset = offsetEnd;
+    }
+    return true;
+}
+
+}
+
+#endif // QMDNSENGINE_MESSAGEVIEW_P_H
@@ -0,0 +1,378 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#include <QHostAddress>
+
+#include <qmdnsengine/bitmap.h>
+#include <qmdnsengine/dns.h>
+
+#include "packetwriter_p.h"
+#include "record_p.h"
+
+using namespace QMdnsEngine;
+
+// The table must be a power of two in size and is only filled to 3/4
+const int TableSize = 512;
+const int TableLimit = TableSize * 3 / 4;
+
+// Compression pointers can only refer to the first 16 KiB of a packet
+const int MaxPointerOffset = 0x3fff;
+
+const int HeaderSize = 12;
+const int InitialBufferSize = 9000;
+
+const quint32 FnvOffset = 2166136261u;
+const quint32 FnvPrime = 16777619u;
+
+PacketWriter::PacketWriter()
+    : length(0),
+      table(TableSize),
+      tableCount(0),
+      generation(0),
+      maxSize(0),
+      nextQuery(0),
+      nextRecord(0),
+      finished(true)
+{
+    buffer.resize(InitialBufferSize);
+    queryName.labels.reserve(256);
+    std::memset(table.data(), 0, TableSize * sizeof(Slot));
+}
+
+void PacketWriter::start(const Message &newMessage, int newMaxSize)
+{
+    message = newMessage;
+    queries = message.queries();
+    records = message.records();
+    maxSize = newMaxSize;
+    nextQuery = 0;
+    nextRecord = 0;
+    finished = false;
+}
+
+bool PacketWriter::writePacket()
+{
+    if (finished) {
+        return false;
+    }
+
+    // Entries from the previous packet are invalidated by moving on to the
+    // next generation rather than clearing the table
+    if (++generation == 0) {
+        std::memset(table.data(), 0, TableSize * sizeof(Slot));
+        generation = 1;
+    }
+    tableCount = 0;
+
+    // Write the header, leaving the flags and counts to be filled in once
+    // the contents of the packet are known
+    length = 0;
+    reserve(HeaderSize);
+    std::memset(buffer.data(), 0, HeaderSize);
+    qToBigEndian<quint16>(message.transactionId(), reinterpret_cast<uchar*>(buffer.data()));
+    length = HeaderSize;
+
+    // Add queries and then records until one does not fit (unless it is the
+    // first item in the packet, in which case it is sent on its own)
+    quint16 nQuestion = 0;
+    quint16 nRecord = 0;
+    bool split = false;
+    bool truncated = false;
+    while (nextQuery < queries.count()) {
+        int previousLength = length;
+        writeQuery(queries.at(nextQuery));
+        if (length > maxSize && nQuestion) {
+            length = previousLength;
+            split = true;
+            break;
+        }
+        ++nQuestion;
+        ++nextQuery;
+    }
+    while (!split && nextRecord < records.count()) {
+        int previousLength = length;
+        writeRecord(records.at(nextRecord));
+        if (length > maxSize && (nQuestion || nRecord)) {
+            length = previousLength;
+            split = true;
+            break;
+        }
+        ++nRecord;
+        ++nextRecord;
+    }
+
+    // When a query is split, the known answers that remain continue in the
+    // next packet, which is indicated by the TC bit (RFC 6762, section 7.2) -
+    // this includes a split among the questions, since all of the known
+    // answers follow them
+    if (split) {
+        truncated = !message.isResponse() && nextRecord < records.count();
+    } else {
+        finished = true;
+        truncated = message.isTruncated();
+    }
+
+    quint16 flags = (message.isResponse() ? 0x8400 : 0) |
+        (truncated ? 0x200 : 0);
+    qToBigEndian<quint16>(flags, reinterpret_cast<uchar*>(buffer.data() + 2));
+    qToBigEndian<quint16>(nQuestion, reinterpret_cast<uchar*>(buffer.data() + 4));
+    qToBigEndian<quint16>(nRecord, reinterpret_cast<uchar*>(buffer.data() + 6));
+    return true;
+}
+
+const char *PacketWriter::data() const
+{
+    return buffer.constData();
+}
+
+int PacketWriter::size() const
+{
+    return length;
+}
+
+void PacketWriter::reserve(int count)
+{
+    if (length + count > buffer.size()) {
+        buffer.resize(qMax(buffer.size() * 2, length + count));
+    }
+}
+
+void PacketWriter::writeBytes(const char *bytes, int count)
+{
+    reserve(count);
+    std::memcpy(buffer.data() + length, bytes, count);
+    length += count;
+}
+
+void PacketWriter::encodeName(const QByteArray &name, WireName &wireName)
+{
+    // Encode each (non-empty) label, recording where it begins
+    wireName.labels.resize(0);
+    wireName.starts.resize(0);
+    const char *text = name.constData();
+    const int textLength = name.length();
+    for (int i = 0; i < textLength;) {
+        const char *dot = static_cast<const char*>(std::memchr(text + i, '.', textLength - i));
+        const int end = dot ? dot - text : textLength;
+        if (end > i) {
+            wireName.starts.append(wireName.labels.length());
+            wireName.labels.append(static_cast<char>(end - i));
+            wireName.labels.append(text + i, end - i);
+        }
+        i = end + 1;
+    }
+    wireName.labels.append('\0');
+
+    // Hash each suffix of the name, beginning with the last label so that
+    // each hash builds on the one for the rest of the name
+    const int count = wireName.starts.count();
+    wireName.hashes.resize(count);
+    quint32 hash = FnvOffset;
+    for (int i = count - 1; i >= 0; --i) {
+        const int start = wireName.starts.at(i);
+        const int end = start + 1 + static_cast<quint8>(wireName.labels.at(start));
+        for (int j = start; j < end; ++j) {
+            hash = (hash ^ static_cast<quint8>(wireName.labels.at(j))) * FnvPrime;
+        }
+        wireName.hashes[i] = hash;
+    }
+}
+
+const WireRecord &PacketWriter::wireRecord(const Record &record)
+{
+    // The encoding is created the first time it is needed; if another
+    // thread creates it at the same time, one of the two is discarded
+    const RecordPrivate *d = record.d.constData();
+    WireRecord *wire = d->wire.pointer.loadAcquire();
+    if (wire) {
+        return *wire;
+    }
+    wire = new WireRecord;
+    encodeName(d->name, wire->name);
+    QByteArray &data = wire->data;
+    switch (d->type) {
+    case A:
+    {
+        quint32 ipv4Addr = qToBigEndian<quint32>(d->address.toIPv4Address());
+        data.append(reinterpret_cast<const char*>(&ipv4Addr), sizeof(quint32));
+        break;
+    }
+    case AAAA:
+    {
+        Q_IPV6ADDR ipv6Addr = d->address.toIPv6Address();
+        data.append(reinterpret_cast<const char*>(&ipv6Addr), sizeof(Q_IPV6ADDR));
+        break;
+    }
+    case NSEC:
+        encodeName(d->nextDomainName, wire->target);
+        data.append('\0');
+        data.append(static_cast<char>(d->bitmap.length()));
+        data.append(reinterpret_cast<const char*>(d->bitmap.data()), d->bitmap.length());
+        break;
+    case PTR:
+        encodeName(d->target, wire->target);
+        break;
+    case SRV:
+    {
+        quint16 fields[] = {
+            qToBigEndian<quint16>(d->priority),
+            qToBigEndian<quint16>(d->weight),
+            qToBigEndian<quint16>(d->port)
+        };
+        data.append(reinterpret_cast<const char*>(fields), sizeof(fields));
+        encodeName(d->target, wire->target);
+        break;
+    }
+    case TXT:
+        if (d->attributes.isEmpty()) {
+            data.append('\0');
+            break;
+        }
+        for (auto i = d->attributes.constBegin(); i != d->attributes.constEnd(); ++i) {
+            const bool hasValue = !i.value().isNull();
+            data.append(static_cast<char>(i.key().length() + (hasValue ? i.value().length() + 1 : 0)));
+            data.append(i.key());
+            if (hasValue) {
+                data.append('=');
+                data.append(i.value());
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    if (!d->wire.pointer.testAndSetOrdered(nullptr, wire)) {
+        delete wire;
+        wire = d->wire.pointer.loadAcquire();
+    }
+    return *wire;
+}
+
+void PacketWriter::writeName(const WireName &wireName)
+{
+    // Copy labels until the rest of the name is found in the packet, at
+    // which point a pointer to it is written instead
+    const char *labels = wireName.labels.constData();
+    const int count = wireName.starts.count();
+    for (int i = 0; i < count; ++i) {
+        const int start = wireName.starts.at(i);
+        const int offset = findName(wireName.hashes.at(i), labels + start);
+        if (offset != -1) {
+            writeInteger<quint16>(static_cast<quint16>(offset | 0xc000));
+            return;
+        }
+        insertName(wireName.hashes.at(i), length);
+        writeBytes(labels + start, static_cast<quint8>(labels[start]) + 1);
+    }
+    writeInteger<quint8>(0);
+}
+
+void PacketWriter::writeQuery(const Query &query)
+{
+    encodeName(query.name(), queryName);
+    writeName(queryName);
+    writeInteger<quint16>(query.type());
+    writeInteger<quint16>(query.unicastResponse() ? 0x8001 : 1);
+}
+
+void PacketWriter::writeRecord(const Record &record)
+{
+    const WireRecord &wire = wireRecord(record);
+    writeName(wire.name);
+    writeInteger<quint16>(record.type());
+    writeInteger<quint16>(record.flushCache() ? 0x8001 : 1);
+    writeInteger<quint32>(record.ttl());
+
+    // Reserve space for the length of the data and fill it in afterwards
+    const int lengthOffset = length;
+    writeInteger<quint16>(0);
+    switch (record.type()) {
+    case NSEC:
+        writeName(wire.target);
+        writeBytes(wire.data.constData(), wire.data.length());
+        break;
+    case PTR:
+        writeName(wire.target);
+        break;
+    case SRV:
+        writeBytes(wire.data.constData(), wire.data.length());
+        writeName(wire.target);
+        break;
+    default:
+        writeBytes(wire.data.constData(), wire.data.length());
+        break;
+    }
+    qToBigEndian<quint16>(static_cast<quint16>(length - lengthOffset - 2),
+        reinterpret_cast<uchar*>(buffer.data() + lengthOffset));
+}
+
+int PacketWriter::findName(quint32 hash, const char *labels) const
+{
+    for (int i = hash & (TableSize - 1);; i = (i + 1) & (TableSize - 1)) {
+        const Slot &slot = table.at(i);
+        if (slot.generation != generation) {
+            return -1;
+        }
+        if (slot.hash == hash && nameEquals(slot.offset, labels)) {
+            return slot.offset;
+        }
+    }
+}
+
+void PacketWriter::insertName(quint32 hash, int offset)
+{
+    if (offset > MaxPointerOffset || tableCount >= TableLimit) {
+        return;
+    }
+    int i = hash & (TableSize - 1);
+    while (table.at(i).generation == generation) {
+        i = (i + 1) & (TableSize - 1);
+    }
+    table[i] = {hash, static_cast<quint16>(offset), generation};
+    ++tableCount;
+}
+
+bool PacketWriter::nameEquals(int offset, const char *labels) const
+{
+    // Compare the labels in the packet (following any pointers) with the
+    // encoded labels; pointers only ever refer to names written earlier
+    const char *packet = buffer.constData();
+    forever {
+        const quint8 nBytes = static_cast<quint8>(packet[offset]);
+        if ((nBytes & 0xc0) == 0xc0) {
+            offset = ((nBytes & ~0xc0) << 8) | static_cast<quint8>(packet[offset + 1]);
+            continue;
+        }
+        if (std::memcmp(packet + offset, labels, nBytes + 1) != 0) {
+            return false;
+        }
+        if (!nBytes) {
+            return true;
+        }
+        offset += nBytes + 1;
+        labels += nBytes + 1;
+    }
+}
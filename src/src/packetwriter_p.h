@@ -0,0 +1,127 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_PACKETWRITER_P_H
+#define QMDNSENGINE_PACKETWRITER_P_H
+
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include <QtEndian>
+
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+namespace QMdnsEngine
+{
+
+// Name encoded as labels (without compression) along with the position and
+// hash of each suffix, ready to be copied into a packet
+struct WireName
+{
+    QByteArray labels;
+    QVector<int> starts;
+    QVector<quint32> hashes;
+};
+
+// Wire encoding of the parts of a record that only change when the record
+// itself does; the data holds everything in the RDATA other than the name
+// (which comes first for NSEC records and last for SRV records)
+struct WireRecord
+{
+    WireName name;
+    WireName target;
+    QByteArray data;
+};
+
+// Writes a message as one or more packets (see toPackets()) into a buffer
+// that is kept between messages; names are compressed using a small
+// open-addressed table of suffix hashes and offsets that is checked against
+// the names already in the buffer, so no memory is allocated per name, and
+// records are written from a wire encoding cached in each record
+class PacketWriter
+{
+public:
+
+    PacketWriter();
+
+    void start(const Message &message, int maxSize);
+    bool writePacket();
+
+    const char *data() const;
+    int size() const;
+
+    static void encodeName(const QByteArray &name, WireName &wireName);
+    static const WireRecord &wireRecord(const Record &record);
+
+private:
+
+    struct Slot
+    {
+        quint32 hash;
+        quint16 offset;
+        quint16 generation;
+    };
+
+    void reserve(int length);
+    void writeBytes(const char *bytes, int length);
+    template<class T>
+    void writeInteger(T value);
+    void writeName(const WireName &wireName);
+    void writeQuery(const Query &query);
+    void writeRecord(const Record &record);
+
+    int findName(quint32 hash, const char *labels) const;
+    void insertName(quint32 hash, int offset);
+    bool nameEquals(int offset, const char *labels) const;
+
+    QByteArray buffer;
+    int length;
+
+    QVector<Slot> table;
+    int tableCount;
+    quint16 generation;
+    WireName queryName;
+
+    Message message;
+    QList<Query> queries;
+    QList<Record> records;
+    int maxSize;
+    int nextQuery;
+    int nextRecord;
+    bool finished;
+};
+
+template<class T>
+void PacketWriter::writeInteger(T value)
+{
+    reserve(sizeof(T));
+    qToBigEndian<T>(value, reinterpret_cast<uchar*>(buffer.data() + length));
+    length += sizeof(T);
+}
+
+}
+
+#endif // QMDNSENGINE_PACKETWRITER_P_H
@@ -28,6 +28,7 @@
 #include <qmdnsengine/prober.h>
 #include <qmdnsengine/query.h>
 
+#include "dispatcher_p.h"
 #include "prober_p.h"
 
 using namespace QMdnsEngine;
@@ -35,6 +36,7 @@ using namespace QMdnsEngine;
 ProberPrivate::ProberPrivate(Prober *prober, AbstractServer *server, const Record &record)
     : QObject(prober),
       server(server),
+      dispatcher(Dispatcher::instance(server)),
       confirmed(false),
       proposedRecord(record),
       suffix(1),
@@ -45,7 +47,9 @@ ProberPrivate::ProberPrivate(Prober *prober, AbstractServer *server, const Recor
     name = record.name().left(index);
     type = record.name().mid(index);
 
-    connect(server, &AbstractServer::messageReceived, this, &ProberPrivate::onMessageReceived);
+    dispatcher->addListener(this, Dispatcher::Responses, [this](const Message &message) {
+        onMessageReceived(message);
+    });
     connect(&timer, &QTimer::timeout, this, &ProberPrivate::onTimeout);
 
     timer.setSingleShot(true);
@@ -62,6 +66,10 @@ void ProberPrivate::assertRecord()
 
 	proposedRecord.setName(tmpName.toUtf8());
 
+    // Only responses for the proposed name and type are of interest
+    dispatcher->unsubscribeAll(this);
+    dispatcher->subscribe(this, proposedRecord.name(), proposedRecord.type());
+
     // Broadcast a query for the proposed name (using an ANY query) and
     // include the proposed record in the query
     Query query;
@@ -97,6 +105,7 @@ void ProberPrivate::onMessageReceived(const Message &message)
 void ProberPrivate::onTimeout()
 {
     confirmed = true;
+    dispatcher->unsubscribeAll(this);
     emit q->nameConfirmed(proposedRecord.name());
 }
 
@@ -34,6 +34,7 @@ namespace QMdnsEngine
 {
 
 class AbstractServer;
+class Dispatcher;
 class Message;
 class Prober;
 
@@ -48,6 +49,7 @@ public:
     void assertRecord();
 
     AbstractServer *server;
+    Dispatcher *dispatcher;
     QTimer timer;
 
     bool confirmed;
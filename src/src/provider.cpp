@@ -29,21 +29,22 @@
 #include <qmdnsengine/message.h>
 #include <qmdnsengine/prober.h>
 #include <qmdnsengine/provider.h>
-#include <qmdnsengine/query.h>
 
 #include "provider_p.h"
+#include "responder_p.h"
 
 using namespace QMdnsEngine;
 
 ProviderPrivate::ProviderPrivate(QObject *parent, AbstractServer *server, Hostname *hostname)
     : QObject(parent),
       server(server),
+      responder(Responder::instance(server)),
       hostname(hostname),
       prober(nullptr),
       initialized(false),
       confirmed(false)
 {
-    connect(server, &AbstractServer::messageReceived, this, &ProviderPrivate::onMessageReceived);
+    connect(server, &AbstractServer::interfacesChanged, this, &ProviderPrivate::onInterfacesChanged);
     connect(hostname, &Hostname::hostnameChanged, this, &ProviderPrivate::onHostnameChanged);
 
     browsePtrProposed.setName(MdnsBrowseType);
@@ -60,15 +61,18 @@ ProviderPrivate::~ProviderPrivate()
     }
 }
 
-void ProviderPrivate::announce()
+void ProviderPrivate::announce(const QList<Record> &records)
 {
-    // Broadcast a message with each of the records
+    // Broadcast a message with each of the records (other than the PTR
+    // record for browsing, which may be shared with other providers)
 
     Message message;
     message.setResponse(true);
-    message.addRecord(ptrRecord);
-    message.addRecord(srvRecord);
-    message.addRecord(txtRecord);
+    for (const Record &record : records) {
+        if (record.name() != MdnsBrowseType) {
+            message.addRecord(record);
+        }
+    }
     server->sendMessageToAll(message);
 }
 
@@ -105,86 +109,24 @@ void ProviderPrivate::confirm()
 
 void ProviderPrivate::farewell()
 {
-    // Send a message indicating that the existing records are no longer valid
-    // by setting their TTL to 0
+    // Withdraw the records from the responder and send a message indicating
+    // that they are no longer valid by setting their TTL to 0
 
-    ptrRecord.setTtl(0);
-    srvRecord.setTtl(0);
-    txtRecord.setTtl(0);
-    announce();
+    QList<Record> records = responder->takeRecords(this);
+    for (Record &record : records) {
+        record.setTtl(0);
+    }
+    announce(records);
 }
 
 void ProviderPrivate::publish()
 {
-    // Copy the proposed records over and announce them
+    // Hand the proposed records to the responder, which answers queries for
+    // them from now on, and announce them
 
-    browsePtrRecord = browsePtrProposed;
-    ptrRecord = ptrProposed;
-    srvRecord = srvProposed;
-    txtRecord = txtProposed;
-    announce();
-}
-
-void ProviderPrivate::onMessageReceived(const Message &message)
-{
-    if (!confirmed || message.isResponse()) {
-        return;
-    }
-
-    bool sendBrowsePtr = false;
-    bool sendPtr = false;
-    bool sendSrv = false;
-    bool sendTxt = false;
-
-    // Determine which records to send based on the queries
-    const auto queries = message.queries();
-    for (const Query &query : queries) {
-        if (query.type() == PTR && query.name() == MdnsBrowseType) {
-            sendBrowsePtr = true;
-        } else if (query.type() == PTR && query.name() == ptrRecord.name()) {
-            sendPtr = true;
-        } else if (query.type() == SRV && query.name() == srvRecord.name()) {
-            sendSrv = true;
-        } else if (query.type() == TXT && query.name() == txtRecord.name()) {
-            sendTxt = true;
-        }
-    }
-
-    // Remove records to send if they are already known
-    const auto records = message.records();
-    for (const Record &record : records) {
-        if (record == ptrRecord) {
-            sendPtr = false;
-        } else if (record == srvRecord) {
-            sendSrv = false;
-        } else if (record == txtRecord) {
-            sendTxt = false;
-        }
-    }
-
-    // Include the SRV and TXT if the PTR is being sent
-    if (sendPtr) {
-        sendSrv = sendTxt = true;
-    }
-
-    // If any records should be sent, compose a message reply
-    if (sendBrowsePtr || sendPtr || sendSrv || sendTxt) {
-        Message reply;
-        reply.reply(message);
-        if (sendBrowsePtr) {
-            reply.addRecord(browsePtrRecord);
-        }
-        if (sendPtr) {
-            reply.addRecord(ptrRecord);
-        }
-        if (sendSrv) {
-            reply.addRecord(srvRecord);
-        }
-        if (sendTxt) {
-            reply.addRecord(txtRecord);
-        }
-        server->sendMessage(reply);
-    }
+    fqName = srvProposed.name();
+    responder->setRecords(this, {browsePtrProposed, ptrProposed, srvProposed, txtProposed});
+    announce(responder->records(this));
 }
 
 void ProviderPrivate::onHostnameChanged(const QByteArray &newHostname)
@@ -198,6 +140,15 @@ void ProviderPrivate::onHostnameChanged(const QByteArray &newHostname)
     }
 }
 
+void ProviderPrivate::onInterfacesChanged()
+{
+    // Announce the published records so that they are known on networks
+    // that were just joined
+    if (confirmed && !prober) {
+        announce(responder->records(this));
+    }
+}
+
 Provider::Provider(AbstractServer *server, Hostname *hostname, QObject *parent)
     : QObject(parent),
       d(new ProviderPrivate(this, server, hostname))
@@ -226,7 +177,7 @@ void Provider::update(const Service &service)
     // Assuming a valid hostname exists, check to see if the new service uses
     // a different name - if so, it must first be confirmed
     if (d->hostname->isRegistered()) {
-        if (!d->confirmed || fqName != d->srvRecord.name()) {
+        if (!d->confirmed || fqName != d->fqName) {
             d->confirm();
         } else {
             d->publish();
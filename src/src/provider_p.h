@@ -25,6 +25,8 @@
 #ifndef QMDNSENGINE_PROVIDER_P_H
 #define QMDNSENGINE_PROVIDER_P_H
 
+#include <QByteArray>
+#include <QList>
 #include <QObject>
 
 #include <qmdnsengine/record.h>
@@ -35,8 +37,8 @@ namespace QMdnsEngine
 
 class AbstractServer;
 class Hostname;
-class Message;
 class Prober;
+class Responder;
 
 class ProviderPrivate : public QObject
 {
@@ -47,23 +49,20 @@ public:
     ProviderPrivate(QObject *parent, AbstractServer *server, Hostname *hostname);
     virtual ~ProviderPrivate();
 
-    void announce();
+    void announce(const QList<Record> &records);
     void confirm();
     void farewell();
     void publish();
 
     AbstractServer *server;
+    Responder *responder;
     Hostname *hostname;
     Prober *prober;
 
     Service service;
     bool initialized;
     bool confirmed;
-
-    Record browsePtrRecord;
-    Record ptrRecord;
-    Record srvRecord;
-    Record txtRecord;
+    QByteArray fqName;
 
     Record browsePtrProposed;
     Record ptrProposed;
@@ -72,8 +71,8 @@ public:
 
 private Q_SLOTS:
 
-    void onMessageReceived(const Message &message);
     void onHostnameChanged(const QByteArray &hostname);
+    void onInterfacesChanged();
 };
 
 }
@@ -28,6 +28,7 @@
 #include <qmdnsengine/query.h>
 
 #include "query_p.h"
+#include "shareddata_p.h"
 
 using namespace QMdnsEngine;
 
@@ -43,20 +44,30 @@ Query::Query()
 }
 
 Query::Query(const Query &other)
-    : d(new QueryPrivate)
+    : d(other.d)
 {
-    *this = other;
 }
 
 Query &Query::operator=(const Query &other)
 {
-    *d = *other.d;
+    d = other.d;
+    return *this;
+}
+
+Query::Query(Query &&other) noexcept
+    : d(sharedNull<QueryPrivate>())
+{
+    d.swap(other.d);
+}
+
+Query &Query::operator=(Query &&other) noexcept
+{
+    d.swap(other.d);
     return *this;
 }
 
 Query::~Query()
 {
-    delete d;
 }
 
 QByteArray Query::name() const
@@ -26,11 +26,12 @@
 #define QMDNSENGINE_QUERY_P_H
 
 #include <QByteArray>
+#include <QSharedData>
 
 namespace QMdnsEngine
 {
 
-class QueryPrivate
+class QueryPrivate : public QSharedData
 {
 public:
 
@@ -0,0 +1,90 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/queryview.h>
+
+#include "messageview_p.h"
+
+using namespace QMdnsEngine;
+
+QueryView::QueryView(const QExplicitlySharedDataPointer<MessageViewPrivate> &d, int index)
+    : d(d),
+      index(index)
+{
+}
+
+QueryView::QueryView(const QueryView &other)
+    : d(other.d),
+      index(other.index)
+{
+}
+
+QueryView &QueryView::operator=(const QueryView &other)
+{
+    d = other.d;
+    index = other.index;
+    return *this;
+}
+
+QueryView::~QueryView()
+{
+}
+
+QByteArray QueryView::name() const
+{
+    QByteArray name;
+    quint16 offset = d->queries.at(index).nameOffset;
+    parseName(d->packet, offset, name);
+    return name;
+}
+
+bool QueryView::nameEquals(const QByteArray &name) const
+{
+    return d->nameEquals(d->queries.at(index).nameOffset, name);
+}
+
+quint16 QueryView::type() const
+{
+    return d->queries.at(index).type;
+}
+
+bool QueryView::unicastResponse() const
+{
+    return d->queries.at(index).class_ & 0x8000;
+}
+
+bool QueryView::toQuery(Query &query) const
+{
+    QByteArray name;
+    quint16 offset = d->queries.at(index).nameOffset;
+    if (!parseName(d->packet, offset, name)) {
+        return false;
+    }
+    query.setName(name);
+    query.setType(type());
+    query.setUnicastResponse(unicastResponse());
+    return true;
+}
@@ -27,10 +27,39 @@
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/record.h>
 
+#include "packetwriter_p.h"
 #include "record_p.h"
+#include "shareddata_p.h"
 
 using namespace QMdnsEngine;
 
+WireCache::WireCache()
+{
+}
+
+WireCache::WireCache(const WireCache &other)
+{
+    *this = other;
+}
+
+WireCache &WireCache::operator=(const WireCache &other)
+{
+    // The parts of the encoding are implicitly shared, so the copy is cheap
+    const WireRecord *wire = other.pointer.loadAcquire();
+    delete pointer.fetchAndStoreOrdered(wire ? new WireRecord(*wire) : nullptr);
+    return *this;
+}
+
+WireCache::~WireCache()
+{
+    delete pointer.loadAcquire();
+}
+
+void WireCache::reset()
+{
+    delete pointer.fetchAndStoreOrdered(nullptr);
+}
+
 RecordPrivate::RecordPrivate()
     : type(0),
       flushCache(false),
@@ -47,19 +76,33 @@ Record::Record()
 }
 
 Record::Record(const Record &other)
-    : d(new RecordPrivate)
+    : d(other.d)
 {
-    *this = other;
 }
 
 Record &Record::operator=(const Record &other)
 {
-    *d = *other.d;
+    d = other.d;
+    return *this;
+}
+
+Record::Record(Record &&other) noexcept
+    : d(sharedNull<RecordPrivate>())
+{
+    d.swap(other.d);
+}
+
+Record &Record::operator=(Record &&other) noexcept
+{
+    d.swap(other.d);
     return *this;
 }
 
 bool Record::operator==(const Record &other) const
 {
+    if (d == other.d) {
+        return true;
+    }
     return d->name == other.d->name &&
         d->type == other.d->type &&
         d->address == other.d->address &&
@@ -79,7 +122,6 @@ bool Record::operator!=(const Record &other) const
 
 Record::~Record()
 {
-    delete d;
 }
 
 QByteArray Record::name() const
@@ -90,6 +132,7 @@ QByteArray Record::name() const
 void Record::setName(const QByteArray &name)
 {
     d->name = name;
+    d->wire.reset();
 }
 
 quint16 Record::type() const
@@ -100,6 +143,7 @@ quint16 Record::type() const
 void Record::setType(quint16 type)
 {
     d->type = type;
+    d->wire.reset();
 }
 
 bool Record::flushCache() const
@@ -130,6 +174,7 @@ QHostAddress Record::address() const
 void Record::setAddress(const QHostAddress &address)
 {
     d->address = address;
+    d->wire.reset();
 }
 
 QByteArray Record::target() const
@@ -140,6 +185,7 @@ QByteArray Record::target() const
 void Record::setTarget(const QByteArray &target)
 {
     d->target = target;
+    d->wire.reset();
 }
 
 QByteArray Record::nextDomainName() const
@@ -150,6 +196,7 @@ QByteArray Record::nextDomainName() const
 void Record::setNextDomainName(const QByteArray &nextDomainName)
 {
     d->nextDomainName = nextDomainName;
+    d->wire.reset();
 }
 
 quint16 Record::priority() const
@@ -160,6 +207,7 @@ quint16 Record::priority() const
 void Record::setPriority(quint16 priority)
 {
     d->priority = priority;
+    d->wire.reset();
 }
 
 quint16 Record::weight() const
@@ -170,6 +218,7 @@ quint16 Record::weight() const
 void Record::setWeight(quint16 weight)
 {
     d->weight = weight;
+    d->wire.reset();
 }
 
 quint16 Record::port() const
@@ -180,6 +229,7 @@ quint16 Record::port() const
 void Record::setPort(quint16 port)
 {
     d->port = port;
+    d->wire.reset();
 }
 
 QMap<QByteArray, QByteArray> Record::attributes() const
@@ -190,11 +240,13 @@ QMap<QByteArray, QByteArray> Record::attributes() const
 void Record::setAttributes(const QMap<QByteArray, QByteArray> &attributes)
 {
     d->attributes = attributes;
+    d->wire.reset();
 }
 
 void Record::addAttribute(const QByteArray &key, const QByteArray &value)
 {
     d->attributes.insert(key, value);
+    d->wire.reset();
 }
 
 Bitmap Record::bitmap() const
@@ -205,6 +257,7 @@ Bitmap Record::bitmap() const
 void Record::setBitmap(const Bitmap &bitmap)
 {
     d->bitmap = bitmap;
+    d->wire.reset();
 }
 
 QDebug QMdnsEngine::operator<<(QDebug dbg, const Record &record)
@@ -27,13 +27,35 @@
 
 #include <QByteArray>
 #include <QHostAddress>
+#include <QAtomicPointer>
 #include <QMap>
+#include <QSharedData>
 
 #include <qmdnsengine/bitmap.h>
 
 namespace QMdnsEngine {
 
-class RecordPrivate
+struct WireRecord;
+
+// Holds the wire encoding of a record once it has been created by the packet
+// writer; the TTL and cache flush bit are not part of it, so a copy made to
+// change those (as most are) takes its own copy of the encoding, while any
+// other change to the record discards it
+class WireCache
+{
+public:
+
+    WireCache();
+    WireCache(const WireCache &other);
+    WireCache &operator=(const WireCache &other);
+    ~WireCache();
+
+    void reset();
+
+    mutable QAtomicPointer<WireRecord> pointer;
+};
+
+class RecordPrivate : public QSharedData
 {
 public:
 
@@ -52,6 +74,8 @@ public:
     quint16 port;
     QMap<QByteArray, QByteArray> attributes;
     Bitmap bitmap;
+
+    WireCache wire;
 };
 
 }
@@ -0,0 +1,226 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/record.h>
+#include <qmdnsengine/recordview.h>
+
+#include "messageview_p.h"
+
+using namespace QMdnsEngine;
+
+RecordView::RecordView(const QExplicitlySharedDataPointer<MessageViewPrivate> &d, int index)
+    : d(d),
+      index(index)
+{
+}
+
+RecordView::RecordView(const RecordView &other)
+    : d(other.d),
+      index(other.index)
+{
+}
+
+RecordView &RecordView::operator=(const RecordView &other)
+{
+    d = other.d;
+    index = other.index;
+    return *this;
+}
+
+RecordView::~RecordView()
+{
+}
+
+QByteArray RecordView::name() const
+{
+    QByteArray name;
+    quint16 offset = d->records.at(index).nameOffset;
+    parseName(d->packet, offset, name);
+    return name;
+}
+
+bool RecordView::nameEquals(const QByteArray &name) const
+{
+    return d->nameEquals(d->records.at(index).nameOffset, name);
+}
+
+bool RecordView::nameEndsWith(const QByteArray &suffix) const
+{
+    return d->nameEndsWith(d->records.at(index).nameOffset, suffix);
+}
+
+quint16 RecordView::type() const
+{
+    return d->records.at(index).type;
+}
+
+bool RecordView::flushCache() const
+{
+    return d->records.at(index).class_ & 0x8000;
+}
+
+quint32 RecordView::ttl() const
+{
+    return d->records.at(index).ttl;
+}
+
+QHostAddress RecordView::address() const
+{
+    const MessageViewPrivate::RecordEntry &entry = d->records.at(index);
+    quint16 offset = entry.dataOffset;
+    switch (entry.type) {
+    case A:
+    {
+        quint32 ipv4Addr;
+        if (d->readData<quint32>(entry, offset, ipv4Addr)) {
+            return QHostAddress(ipv4Addr);
+        }
+        break;
+    }
+    case AAAA:
+        if (entry.dataLength >= 16) {
+            return QHostAddress(reinterpret_cast<const quint8*>(d->packet.constData() + offset));
+        }
+        break;
+    }
+    return QHostAddress();
+}
+
+QByteArray RecordView::target() const
+{
+    const MessageViewPrivate::RecordEntry &entry = d->records.at(index);
+    quint16 offset = entry.dataOffset;
+    QByteArray target;
+    switch (entry.type) {
+    case SRV:
+        offset += 6;
+        // Fall through
+    case PTR:
+        if (!d->parseDataName(entry, offset, target)) {
+            return QByteArray();
+        }
+        break;
+    }
+    return target;
+}
+
+QByteArray RecordView::nextDomainName() const
+{
+    const MessageViewPrivate::RecordEntry &entry = d->records.at(index);
+    quint16 offset = entry.dataOffset;
+    QByteArray nextDomainName;
+    if (entry.type != NSEC || !d->parseDataName(entry, offset, nextDomainName)) {
+        return QByteArray();
+    }
+    return nextDomainName;
+}
+
+quint16 RecordView::priority() const
+{
+    const MessageViewPrivate::RecordEntry &entry = d->records.at(index);
+    quint16 offset = entry.dataOffset;
+    quint16 priority = 0;
+    if (entry.type == SRV) {
+        d->readData<quint16>(entry, offset, priority);
+    }
+    return priority;
+}
+
+quint16 RecordView::weight() const
+{
+    const MessageViewPrivate::RecordEntry &entry = d->records.at(index);
+    quint16 offset = entry.dataOffset + 2;
+    quint16 weight = 0;
+    if (entry.type == SRV) {
+        d->readData<quint16>(entry, offset, weight);
+    }
+    return weight;
+}
+
+quint16 RecordView::port() const
+{
+    const MessageViewPrivate::RecordEntry &entry = d->records.at(index);
+    quint16 offset = entry.dataOffset + 4;
+    quint16 port = 0;
+    if (entry.type == SRV) {
+        d->readData<quint16>(entry, offset, port);
+    }
+    return port;
+}
+
+QMap<QByteArray, QByteArray> RecordView::attributes() const
+{
+    // The attributes are decoded from the record data, one length-prefixed
+    // "key=value" entry at a time
+    const MessageViewPrivate::RecordEntry &entry = d->records.at(index);
+    QMap<QByteArray, QByteArray> attributes;
+    if (entry.type != TXT) {
+        return attributes;
+    }
+    quint16 offset = entry.dataOffset;
+    quint16 end = entry.dataOffset + entry.dataLength;
+    while (offset < end) {
+        quint8 nBytes;
+        if (!d->readInteger<quint8>(offset, nBytes) || offset + nBytes > end) {
+            break;
+        }
+        if (nBytes == 0) {
+            break;
+        }
+        QByteArray attr(d->packet.constData() + offset, nBytes);
+        offset += nBytes;
+        int splitIndex = attr.indexOf('=');
+        if (splitIndex == -1) {
+            attributes.insert(attr, QByteArray());
+        } else {
+            attributes.insert(attr.left(splitIndex), attr.mid(splitIndex + 1));
+        }
+    }
+    return attributes;
+}
+
+Bitmap RecordView::bitmap() const
+{
+    const MessageViewPrivate::RecordEntry &entry = d->records.at(index);
+    quint16 offset = entry.dataOffset;
+    quint8 number;
+    quint8 length;
+    Bitmap bitmap;
+    if (entry.type == NSEC &&
+            d->skipName(offset) &&
+            d->readData<quint8>(entry, offset, number) &&
+            d->readData<quint8>(entry, offset, length) &&
+            number == 0 &&
+            offset + length <= entry.dataOffset + entry.dataLength) {
+        bitmap.setData(length, reinterpret_cast<const quint8*>(d->packet.constData() + offset));
+    }
+    return bitmap;
+}
+
+bool RecordView::toRecord(Record &record) const
+{
+    quint16 offset = d->records.at(index).nameOffset;
+    return parseRecord(d->packet, offset, record);
+}
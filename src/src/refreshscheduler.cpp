@@ -0,0 +1,136 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/cache.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+#include "refreshscheduler_p.h"
+
+using namespace QMdnsEngine;
+
+// Time in milliseconds that records due to be refreshed are gathered before
+// the query is sent
+const int RefreshWindow = 250;
+
+RefreshScheduler::RefreshScheduler(AbstractServer *server, Cache *cache)
+    : QObject(cache),
+      server(server),
+      cache(cache)
+{
+    connect(cache, &Cache::shouldQuery, this, &RefreshScheduler::onShouldQuery);
+    connect(server, &QObject::destroyed, this, &RefreshScheduler::onServerDestroyed);
+    connect(&timer, &QTimer::timeout, this, &RefreshScheduler::onTimeout);
+
+    timer.setInterval(RefreshWindow);
+    timer.setSingleShot(true);
+}
+
+RefreshScheduler *RefreshScheduler::instance(AbstractServer *server, Cache *cache)
+{
+    const auto schedulers = cache->findChildren<RefreshScheduler*>(QString(), Qt::FindDirectChildrenOnly);
+    for (RefreshScheduler *scheduler : schedulers) {
+        if (scheduler->server == server) {
+            return scheduler;
+        }
+    }
+    return new RefreshScheduler(server, cache);
+}
+
+void RefreshScheduler::addConsumer(QObject *consumer)
+{
+    if (!consumers.contains(consumer)) {
+        consumers.insert(consumer);
+        connect(consumer, &QObject::destroyed, this, &RefreshScheduler::onConsumerDestroyed);
+    }
+}
+
+Statistics RefreshScheduler::statistics() const
+{
+    return recorder.snapshot();
+}
+
+void RefreshScheduler::onShouldQuery(const Record &record)
+{
+    // Records are only refreshed while something is using the cache with
+    // this server; each name and type is queried once per window
+    if (!server || consumers.isEmpty()) {
+        return;
+    }
+    Key key(record.name(), record.type());
+    if (pendingKeys.contains(key)) {
+        return;
+    }
+    pendingKeys.insert(key);
+    pending.append(key);
+    if (!timer.isActive()) {
+        timer.start();
+    }
+}
+
+void RefreshScheduler::onTimeout()
+{
+    // Every question goes into a single message along with the known
+    // answers; the server packs it into as few packets as its maximum packet
+    // size allows, setting the TC bit on each packet but the last so that
+    // responders wait for all of the known answers
+    Message message;
+    QList<Record> records;
+    for (const Key &key : qAsConst(pending)) {
+        Query query;
+        query.setName(key.first);
+        query.setType(key.second);
+        message.addQuery(query);
+        cache->lookupKnownAnswers(key.first, key.second, records);
+    }
+    for (const Record &record : qAsConst(records)) {
+        message.addRecord(record);
+    }
+    if (!pending.isEmpty()) {
+        server->sendMessageToAll(message);
+        recorder.add(Statistics::QueriesSent);
+    }
+    pending.clear();
+    pendingKeys.clear();
+}
+
+void RefreshScheduler::onConsumerDestroyed(QObject *consumer)
+{
+    consumers.remove(consumer);
+    if (consumers.isEmpty()) {
+        timer.stop();
+        pending.clear();
+        pendingKeys.clear();
+    }
+}
+
+void RefreshScheduler::onServerDestroyed()
+{
+    // The scheduler belongs to the cache, which may outlive the server
+    server = nullptr;
+    timer.stop();
+    deleteLater();
+}
@@ -0,0 +1,86 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_REFRESHSCHEDULER_P_H
+#define QMDNSENGINE_REFRESHSCHEDULER_P_H
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+#include <QTimer>
+
+#include <qmdnsengine/statistics.h>
+
+#include "statistics_p.h"
+
+namespace QMdnsEngine
+{
+
+class AbstractServer;
+class Cache;
+class Record;
+
+// Each cache has a single refresh scheduler per server, shared by the
+// browsers and resolvers using them; the records that are due to be
+// refreshed during a short window are gathered and queried together in a
+// single message along with their known answers
+class RefreshScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    static RefreshScheduler *instance(AbstractServer *server, Cache *cache);
+
+    void addConsumer(QObject *consumer);
+
+    Statistics statistics() const;
+
+private Q_SLOTS:
+
+    void onShouldQuery(const Record &record);
+    void onTimeout();
+    void onConsumerDestroyed(QObject *consumer);
+    void onServerDestroyed();
+
+private:
+
+    typedef QPair<QByteArray, quint16> Key;
+
+    RefreshScheduler(AbstractServer *server, Cache *cache);
+
+    AbstractServer *server;
+    Cache *cache;
+    QSet<QObject*> consumers;
+    QList<Key> pending;
+    QSet<Key> pendingKeys;
+    QTimer timer;
+    StatisticsRecorder recorder;
+};
+
+}
+
+#endif // QMDNSENGINE_REFRESHSCHEDULER_P_H
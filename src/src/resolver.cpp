@@ -32,6 +32,8 @@
 #include <qmdnsengine/record.h>
 #include <qmdnsengine/resolver.h>
 
+#include "dispatcher_p.h"
+#include "refreshscheduler_p.h"
 #include "resolver_p.h"
 
 using namespace QMdnsEngine;
@@ -43,9 +45,18 @@ ResolverPrivate::ResolverPrivate(Resolver *resolver, AbstractServer *server, con
       cache(cache ? cache : new Cache(this)),
       q(resolver)
 {
-    connect(server, &AbstractServer::messageReceived, this, &ResolverPrivate::onMessageReceived);
+    Dispatcher *dispatcher = Dispatcher::instance(server);
+    dispatcher->addListener(this, Dispatcher::Responses, [this](const Message &message) {
+        onMessageReceived(message);
+    });
+    dispatcher->subscribe(this, name, A);
+    dispatcher->subscribe(this, name, AAAA);
+
     connect(&timer, &QTimer::timeout, this, &ResolverPrivate::onTimeout);
 
+    // Keep the addresses in the cache fresh while resolving
+    RefreshScheduler::instance(server, this->cache)->addConsumer(this);
+
     // Query for new records
     query();
 
@@ -0,0 +1,449 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <limits>
+
+#include <QtGlobal>
+#if(QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+#include <QRandomGenerator>
+#define USE_QRANDOMGENERATOR
+#endif
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/query.h>
+
+#include "dispatcher_p.h"
+#include "responder_p.h"
+
+using namespace QMdnsEngine;
+
+// Answers containing shared records are delayed by 20-120 ms so that other
+// responders' answers can be observed and aggregated
+const int SharedDelayMin = 20;
+const int SharedDelayRange = 101;
+
+// The same record is multicast at most once per second
+const qint64 MulticastInterval = 1000;
+
+// Known answers for a truncated query are collected for 400-500 ms
+const int TruncatedDelayMin = 400;
+const int TruncatedDelayRange = 101;
+
+// Shared records (such as PTR records for browsing) may be answered by more
+// than one host; all other records are unique to this host
+static bool isShared(const Record &record)
+{
+    return !record.flushCache() && record.type() == PTR;
+}
+
+Responder::Responder(AbstractServer *server)
+    : QObject(server),
+      server(server),
+      dispatcher(Dispatcher::instance(server))
+{
+    dispatcher->addListener(this, Dispatcher::Queries | Dispatcher::KnownAnswers, [this](const Message &message) {
+        onMessageReceived(message);
+    });
+    connect(&timer, &QTimer::timeout, this, &Responder::onTimeout);
+
+    timer.setSingleShot(true);
+    clock.start();
+}
+
+Responder *Responder::instance(AbstractServer *server)
+{
+    Responder *responder = server->findChild<Responder*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!responder) {
+        responder = new Responder(server);
+    }
+    return responder;
+}
+
+void Responder::setRecords(QObject *owner, const QList<Record> &records)
+{
+    removeEntries(owner);
+    if (records.isEmpty()) {
+        return;
+    }
+    if (!owners.contains(owner)) {
+        connect(owner, &QObject::destroyed, this, &Responder::onOwnerDestroyed);
+    }
+    owners.insert(owner, records);
+    for (const Record &record : records) {
+        insertEntry({owner, record});
+    }
+}
+
+QList<Record> Responder::records(QObject *owner) const
+{
+    return owners.value(owner);
+}
+
+QList<Record> Responder::takeRecords(QObject *owner)
+{
+    QList<Record> records = owners.value(owner);
+    removeEntries(owner);
+    return records;
+}
+
+void Responder::respond(const Message &query, const QList<Record> &records)
+{
+    if (records.isEmpty()) {
+        return;
+    }
+    Message reply;
+    reply.reply(query);
+
+    // Legacy unicast queries (not from the mDNS port) are answered directly
+    if (query.port() != MdnsPort) {
+        for (const Record &record : records) {
+            reply.addRecord(record);
+        }
+        server->sendMessage(reply);
+        return;
+    }
+
+    // Unique answers are sent as soon as control returns to the event loop,
+    // allowing answers to other queries in the same packet to be merged
+    qint64 now = clock.elapsed();
+    qint64 time = now;
+    for (const Record &record : records) {
+        if (isShared(record)) {
+#ifdef USE_QRANDOMGENERATOR
+            time += SharedDelayMin + QRandomGenerator::global()->bounded(SharedDelayRange);
+#else
+            time += SharedDelayMin + qrand() % SharedDelayRange;
+#endif
+            break;
+        }
+    }
+
+    // If a response to the same destination is already pending, merge the
+    // answers into it rather than sending another packet
+    Destination destination{reply.address(), reply.port(), reply.interfaceIndex()};
+    auto i = responses.find(destination);
+    if (i == responses.end()) {
+        for (const Record &record : records) {
+            reply.addRecord(record);
+        }
+        responses.insert(destination, {reply, time});
+    } else {
+        Response &response = i.value();
+        const auto pendingRecords = response.message.records();
+        for (const Record &record : records) {
+            if (!pendingRecords.contains(record)) {
+                response.message.addRecord(record);
+            }
+        }
+        response.time = qMin(response.time, time);
+        statistics.add(Statistics::MergedAnswers);
+    }
+
+    startTimer(now);
+}
+
+void Responder::collectStatistics(Statistics &snapshot) const
+{
+    statistics.collect(snapshot);
+}
+
+void Responder::onOwnerDestroyed(QObject *owner)
+{
+    removeEntries(owner);
+}
+
+void Responder::insertEntry(const Entry &entry)
+{
+    // Add the entry to the bucket for its name and type, subscribing to
+    // queries for them if the bucket is new
+    Key key(entry.record.name(), entry.record.type());
+    auto i = entries.find(key);
+    if (i == entries.end()) {
+        i = entries.insert(key, QList<Entry>());
+        types[key.first].append(key.second);
+        dispatcher->subscribe(this, key.first, key.second);
+    }
+    i.value().append(entry);
+}
+
+void Responder::removeEntries(QObject *owner)
+{
+    auto i = owners.find(owner);
+    if (i == owners.end()) {
+        return;
+    }
+    const auto records = i.value();
+    owners.erase(i);
+    disconnect(owner, &QObject::destroyed, this, &Responder::onOwnerDestroyed);
+
+    // Remove the owner's entries from each bucket it added records to,
+    // removing the bucket (and the subscription) once it is empty
+    for (const Record &record : records) {
+        Key key(record.name(), record.type());
+        auto j = entries.find(key);
+        if (j == entries.end()) {
+            continue;
+        }
+        QList<Entry> &bucket = j.value();
+        for (int k = 0; k < bucket.count(); ++k) {
+            if (bucket.at(k).owner == owner) {
+                bucket.removeAt(k);
+                break;
+            }
+        }
+        if (bucket.isEmpty()) {
+            entries.erase(j);
+            auto t = types.find(key.first);
+            t.value().removeOne(key.second);
+            if (t.value().isEmpty()) {
+                types.erase(t);
+            }
+            dispatcher->unsubscribe(this, key.first, key.second);
+        }
+    }
+}
+
+void Responder::appendRecords(const Key &key, QSet<Key> &visited, QList<Record> &records) const
+{
+    if (visited.contains(key)) {
+        return;
+    }
+    visited.insert(key);
+
+    // Identical records published by more than one owner (such as the PTR
+    // record for browsing a service type) are only included once
+    auto i = entries.constFind(key);
+    if (i == entries.constEnd()) {
+        return;
+    }
+    const int start = records.count();
+    for (const Entry &entry : i.value()) {
+        bool duplicate = false;
+        for (int j = start; j < records.count(); ++j) {
+            if (records.at(j) == entry.record) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate) {
+            records.append(entry.record);
+        }
+    }
+}
+
+void Responder::onMessageReceived(const Message &message)
+{
+    // A truncated query is followed by more packets from the same source
+    // with the rest of its known answers; combine them until a packet
+    // without the TC bit arrives or the delay runs out
+    Destination source{message.address(), message.port(), message.interfaceIndex()};
+    auto i = truncated.find(source);
+    if (i == truncated.end() && !message.isTruncated()) {
+        if (message.queries().count()) {
+            answer(message);
+        }
+        return;
+    }
+    qint64 now = clock.elapsed();
+    if (i == truncated.end()) {
+        if (message.queries().isEmpty()) {
+            return;
+        }
+#ifdef USE_QRANDOMGENERATOR
+        qint64 time = now + TruncatedDelayMin + QRandomGenerator::global()->bounded(TruncatedDelayRange);
+#else
+        qint64 time = now + TruncatedDelayMin + qrand() % TruncatedDelayRange;
+#endif
+        truncated.insert(source, {message, time});
+    } else {
+        Message &combined = i.value().message;
+        const auto queries = message.queries();
+        for (const Query &query : queries) {
+            combined.addQuery(query);
+        }
+        const auto records = message.records();
+        for (const Record &record : records) {
+            combined.addRecord(record);
+        }
+    }
+    if (!message.isTruncated()) {
+        Message combined = truncated.take(source).message;
+        answer(combined);
+    }
+    startTimer(now);
+}
+
+void Responder::answer(const Message &message)
+{
+    // Collect every record matching one of the queries
+    QSet<Key> visited;
+    QList<Record> records;
+    const auto queries = message.queries();
+    for (const Query &query : queries) {
+        if (query.type() == ANY) {
+            const auto queryTypes = types.value(query.name());
+            for (quint16 type : queryTypes) {
+                appendRecords(Key(query.name(), type), visited, records);
+            }
+        } else {
+            appendRecords(Key(query.name(), query.type()), visited, records);
+        }
+    }
+
+    // Remove records that are already known by the querier, provided that
+    // the known answer's TTL is at least half of the true TTL
+    const auto knownRecords = message.records();
+    if (!knownRecords.isEmpty()) {
+        QHash<Key, QList<Record>> known;
+        for (const Record &record : knownRecords) {
+            known[Key(record.name(), record.type())].append(record);
+        }
+        for (int i = 0; i < records.count();) {
+            const Record &record = records.at(i);
+            bool isKnown = false;
+            const auto candidates = known.value(Key(record.name(), record.type()));
+            for (const Record &candidate : candidates) {
+                if (candidate == record && candidate.ttl() >= record.ttl() / 2) {
+                    isKnown = true;
+                    break;
+                }
+            }
+            if (isKnown) {
+                records.removeAt(i);
+                statistics.add(Statistics::SuppressedAnswers);
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    // Include the SRV and TXT records for each PTR record being sent
+    const int answerCount = records.count();
+    for (int i = 0; i < answerCount; ++i) {
+        if (records.at(i).type() == PTR) {
+            appendRecords(Key(records.at(i).target(), SRV), visited, records);
+            appendRecords(Key(records.at(i).target(), TXT), visited, records);
+        }
+    }
+
+    respond(message, records);
+}
+
+void Responder::onTimeout()
+{
+    // Answer truncated queries whose remaining known answers did not arrive
+    // in time with the known answers received so far
+    qint64 now = clock.elapsed();
+    for (auto i = truncated.begin(); i != truncated.end();) {
+        if (i.value().time <= now) {
+            Message combined = i.value().message;
+            i = truncated.erase(i);
+            answer(combined);
+        } else {
+            ++i;
+        }
+    }
+
+    // Send each response that is due, leaving out records that were already
+    // multicast within the last second
+    for (auto i = responses.begin(); i != responses.end();) {
+        if (i.value().time > now) {
+            ++i;
+            continue;
+        }
+        const Message &pending = i.value().message;
+        const bool multicast = pending.address().isMulticast();
+        Message reply;
+        reply.setAddress(pending.address());
+        reply.setPort(pending.port());
+        reply.setInterfaceIndex(pending.interfaceIndex());
+        reply.setTransactionId(pending.transactionId());
+        reply.setResponse(true);
+        const auto records = pending.records();
+        for (const Record &record : records) {
+            if (multicast && multicastRecently(record, i.key(), now)) {
+                statistics.add(Statistics::SuppressedAnswers);
+            } else {
+                reply.addRecord(record);
+            }
+        }
+        i = responses.erase(i);
+        if (reply.records().count()) {
+            server->sendMessage(reply);
+        }
+    }
+
+    // Forget multicasts that no longer limit anything once the table has
+    // grown past the number of records that could be in it
+    if (multicasts.count() > entries.count() + 64) {
+        for (auto i = multicasts.begin(); i != multicasts.end();) {
+            if (i.value().last().time <= now - MulticastInterval) {
+                i = multicasts.erase(i);
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    startTimer(now);
+}
+
+bool Responder::multicastRecently(const Record &record, const Destination &destination, qint64 now)
+{
+    // Drop the multicasts for the name and type that are over a second old
+    // and check the rest for the record; if it is not present, it is about
+    // to be sent and is added - a multicast on one interface does not reach
+    // the others
+    QList<Multicast> &sent = multicasts[Key(record.name(), record.type())];
+    while (!sent.isEmpty() && sent.first().time <= now - MulticastInterval) {
+        sent.removeFirst();
+    }
+    for (const Multicast &multicast : qAsConst(sent)) {
+        if (multicast.address == destination.address &&
+                multicast.interfaceIndex == destination.interfaceIndex &&
+                multicast.record == record) {
+            return true;
+        }
+    }
+    sent.append({record, destination.address, destination.interfaceIndex, now});
+    return false;
+}
+
+void Responder::startTimer(qint64 now)
+{
+    if (responses.isEmpty() && truncated.isEmpty()) {
+        timer.stop();
+        return;
+    }
+    qint64 next = std::numeric_limits<qint64>::max();
+    for (auto i = responses.constBegin(); i != responses.constEnd(); ++i) {
+        next = qMin(next, i.value().time);
+    }
+    for (auto i = truncated.constBegin(); i != truncated.constEnd(); ++i) {
+        next = qMin(next, i.value().time);
+    }
+    timer.start(static_cast<int>(qMax<qint64>(0, next - now)));
+}
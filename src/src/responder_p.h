@@ -0,0 +1,150 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_RESPONDER_P_H
+#define QMDNSENGINE_RESPONDER_P_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+#include <QTimer>
+
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/record.h>
+
+#include "statistics_p.h"
+
+namespace QMdnsEngine
+{
+
+class AbstractServer;
+class Dispatcher;
+
+// Each server has a single responder that holds the records published by
+// all local components (indexed by name and type) and answers each query
+// with one reply containing every matching record; replies are scheduled as
+// described in section 6 of RFC 6762 so that answers to the same destination
+// are merged and no record is multicast more than once per second; known
+// answers are honored as described in section 7 of RFC 6762, including
+// those spread across truncated query packets
+class Responder : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    typedef QPair<QByteArray, quint16> Key;
+
+    // Replies to the same address and port on different interfaces are kept
+    // apart since each is only sent on its own interface
+    struct Destination
+    {
+        QHostAddress address;
+        quint16 port;
+        int interfaceIndex;
+
+        bool operator==(const Destination &other) const
+        {
+            return address == other.address && port == other.port &&
+                    interfaceIndex == other.interfaceIndex;
+        }
+    };
+
+    static Responder *instance(AbstractServer *server);
+
+    void setRecords(QObject *owner, const QList<Record> &records);
+    QList<Record> records(QObject *owner) const;
+    QList<Record> takeRecords(QObject *owner);
+
+    void respond(const Message &query, const QList<Record> &records);
+
+    void collectStatistics(Statistics &snapshot) const;
+
+private Q_SLOTS:
+
+    void onMessageReceived(const Message &message);
+    void onOwnerDestroyed(QObject *owner);
+    void onTimeout();
+
+private:
+
+    struct Entry
+    {
+        QObject *owner;
+        Record record;
+    };
+
+    struct Response
+    {
+        Message message;
+        qint64 time;
+    };
+
+    struct Multicast
+    {
+        Record record;
+        QHostAddress address;
+        int interfaceIndex;
+        qint64 time;
+    };
+
+    explicit Responder(AbstractServer *server);
+
+    void insertEntry(const Entry &entry);
+    void removeEntries(QObject *owner);
+    void appendRecords(const Key &key, QSet<Key> &visited, QList<Record> &records) const;
+    void answer(const Message &message);
+
+    bool multicastRecently(const Record &record, const Destination &destination, qint64 now);
+    void startTimer(qint64 now);
+
+    AbstractServer *server;
+    Dispatcher *dispatcher;
+
+    QHash<Key, QList<Entry>> entries;
+    QHash<QByteArray, QList<quint16>> types;
+    QHash<QObject*, QList<Record>> owners;
+
+    QTimer timer;
+    QElapsedTimer clock;
+    QHash<Destination, Response> responses;
+    QHash<Destination, Response> truncated;
+    QHash<Key, QList<Multicast>> multicasts;
+    StatisticsRecorder statistics;
+};
+
+inline uint qHash(const Responder::Destination &destination, uint seed = 0)
+{
+    return qHash(destination.address, seed) ^ destination.port ^
+            (static_cast<uint>(destination.interfaceIndex) << 16);
+}
+
+}
+
+#endif // QMDNSENGINE_RESPONDER_P_H
@@ -22,114 +22,122 @@
  * IN THE SOFTWARE.
  */
 
-#include <QtGlobal>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
 
-#ifdef Q_OS_UNIX
-#  include <cerrno>
-#  include <cstring>
-#  include <sys/socket.h>
-#endif
-
-#include <QHostAddress>
-#include <QNetworkInterface>
-
-#include <qmdnsengine/dns.h>
 #include <qmdnsengine/mdns.h>
 #include <qmdnsengine/message.h>
 #include <qmdnsengine/server.h>
 
+#include "responder_p.h"
 #include "server_p.h"
+#include "serverworker_p.h"
 
 using namespace QMdnsEngine;
 
 ServerPrivate::ServerPrivate(Server *server)
     : QObject(server),
+      receiveBatchSize(32),
+      maxPacketSize(MdnsMaxPacketSize),
+      sendBatchDelay(0),
+      duplicateWindow(0),
+      duplicateIgnoresSource(false),
+      ownMessagesDelivered(false),
+      worker(nullptr),
+      thread(nullptr),
       q(server)
 {
-    connect(&timer, &QTimer::timeout, this, &ServerPrivate::onTimeout);
-    connect(&ipv4Socket, &QUdpSocket::readyRead, this, &ServerPrivate::onReadyRead);
-    connect(&ipv6Socket, &QUdpSocket::readyRead, this, &ServerPrivate::onReadyRead);
-
-    timer.setInterval(60 * 1000);
-    timer.setSingleShot(true);
-    onTimeout();
+    createWorker(false);
 }
 
-bool ServerPrivate::bindSocket(QUdpSocket &socket, const QHostAddress &address)
+ServerPrivate::~ServerPrivate()
 {
-    // Exit early if the socket is already bound
-    if (socket.state() == QAbstractSocket::BoundState) {
-        return true;
-    }
+    destroyWorker();
+}
 
-    // I cannot find the correct combination of flags that allows the socket
-    // to bind properly on Linux, so on that platform, we must manually create
-    // the socket and initialize the QUdpSocket with it
-
-#ifdef Q_OS_UNIX
-    if (!socket.bind(address, MdnsPort, QAbstractSocket::ShareAddress)) {
-        int arg = 1;
-        if (setsockopt(socket.socketDescriptor(), SOL_SOCKET, SO_REUSEADDR,
-                reinterpret_cast<char*>(&arg), sizeof(int))) {
-            emit q->error(strerror(errno));
-            return false;
-        }
-#endif
-        if (!socket.bind(address, MdnsPort, QAbstractSocket::ReuseAddressHint)) {
-            emit q->error(socket.errorString());
-            return false;
-        }
-#ifdef Q_OS_UNIX
+void ServerPrivate::createWorker(bool threaded)
+{
+    worker = new ServerWorker(this, threaded);
+    connect(worker, &ServerWorker::error, q, &Server::error);
+    connect(worker, &ServerWorker::interfacesChanged, q, &Server::interfacesChanged);
+    if (!threaded) {
+        worker->start();
+        return;
     }
-#endif
 
-    return true;
+    // The worker is deleted in its own thread once the thread finishes
+    thread = new QThread(this);
+    worker->moveToThread(thread);
+    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+    thread->start();
+    QMetaObject::invokeMethod(worker, "start", Qt::QueuedConnection);
 }
 
-void ServerPrivate::onTimeout()
+void ServerPrivate::destroyWorker()
 {
-    // A timer is used to run a set of operations once per minute; first, the
-    // two sockets are bound - if this fails, another attempt is made once per
-    // timeout; secondly, all network interfaces are enumerated; if the
-    // interface supports multicast, the socket will join the mDNS multicast
-    // groups
+    if (thread) {
+        thread->quit();
+        thread->wait();
+        delete thread;
+        thread = nullptr;
+    } else {
+        delete worker;
+    }
+    worker = nullptr;
+}
 
-    bool ipv4Bound = bindSocket(ipv4Socket, QHostAddress::AnyIPv4);
-    bool ipv6Bound = bindSocket(ipv6Socket, QHostAddress::AnyIPv6);
+void ServerPrivate::deliverMessage(const Message &message)
+{
+    if (!statistics.histogramsEnabled.loadAcquire()) {
+        emit q->messageReceived(message);
+        return;
+    }
+    QElapsedTimer handlerTimer;
+    handlerTimer.start();
+    emit q->messageReceived(message);
+    statistics.record(Statistics::HandlerLatency, handlerTimer.nsecsElapsed() / 1000);
+}
 
-    if (ipv4Bound || ipv6Bound) {
-        const auto interfaces = QNetworkInterface::allInterfaces();
-        for (const QNetworkInterface &networkInterface : interfaces) {
-            if (networkInterface.flags() & QNetworkInterface::CanMulticast) {
-                if (ipv4Bound) {
-                    ipv4Socket.joinMulticastGroup(MdnsIpv4Address, networkInterface);
-                }
-                if (ipv6Bound) {
-                    ipv6Socket.joinMulticastGroup(MdnsIpv6Address, networkInterface);
-                }
-            }
+void ServerPrivate::sendMessage(const Message &message, bool all)
+{
+    // Multicast messages that are dropped when looped back are handed to
+    // the listeners of the server directly instead, as if received from
+    // this host; they are queued like received messages so that they are
+    // never delivered while the sender is still running
+    if ((all || message.address().isMulticast()) && !ownMessagesDelivered.loadAcquire()) {
+        Message own = message;
+        own.setAddress(QHostAddress::LocalHost);
+        own.setPort(MdnsPort);
+        if (incoming.push(own)) {
+            QMetaObject::invokeMethod(this, "onMessagesQueued", Qt::QueuedConnection);
         }
     }
 
-    timer.start();
+    // Messages for the I/O thread are queued in the same way as messages
+    // received from it
+    if (!thread) {
+        if (all) {
+            worker->sendMessageToAll(message);
+        } else {
+            worker->sendMessage(message);
+        }
+    } else if (worker->outgoing.push({message, all})) {
+        QMetaObject::invokeMethod(worker, "onMessagesQueued", Qt::QueuedConnection);
+    }
 }
 
-void ServerPrivate::onReadyRead()
+InterfaceFilter ServerPrivate::interfaceFilter()
 {
-    // Read the packet from the socket
-    QUdpSocket *socket = qobject_cast<QUdpSocket*>(sender());
-    QByteArray packet;
-    packet.resize(socket->pendingDatagramSize());
-    QHostAddress address;
-    quint16 port;
-    socket->readDatagram(packet.data(), packet.size(), &address, &port);
+    QMutexLocker locker(&filterMutex);
+    return filter;
+}
 
-    // Attempt to decode the packet
-    Message message;
-    if (fromPacket(packet, message)) {
-        message.setAddress(address);
-        message.setPort(port);
-        emit q->messageReceived(message);
+void ServerPrivate::onMessagesQueued()
+{
+    const auto messages = incoming.takeAll();
+    for (const Message &message : messages) {
+        deliverMessage(message);
     }
 }
 
@@ -139,21 +147,132 @@ Server::Server(QObject *parent)
 {
 }
 
-void Server::sendMessage(const Message &message)
+bool Server::isIoThreadEnabled() const
 {
-    QByteArray packet;
-    toPacket(message, packet);
-    if (message.address().protocol() == QAbstractSocket::IPv4Protocol) {
-        d->ipv4Socket.writeDatagram(packet, message.address(), message.port());
-    } else {
-        d->ipv6Socket.writeDatagram(packet, message.address(), message.port());
+    return d->thread;
+}
+
+void Server::setIoThreadEnabled(bool ioThreadEnabled)
+{
+    // The old worker sends whatever is queued before it is destroyed and
+    // the messages it received are delivered before the new one starts
+    if (ioThreadEnabled != isIoThreadEnabled()) {
+        d->destroyWorker();
+        d->onMessagesQueued();
+        d->createWorker(ioThreadEnabled);
+    }
+}
+
+InterfaceFilter Server::interfaceFilter() const
+{
+    return d->interfaceFilter();
+}
+
+void Server::setInterfaceFilter(const InterfaceFilter &interfaceFilter)
+{
+    {
+        QMutexLocker locker(&d->filterMutex);
+        d->filter = interfaceFilter;
     }
+
+    // Have the worker apply the filter as soon as it returns to its event
+    // loop, in whichever thread that is
+    QMetaObject::invokeMethod(d->worker, "onTimeout", Qt::QueuedConnection);
+}
+
+int Server::receiveBatchSize() const
+{
+    return d->receiveBatchSize.loadAcquire();
+}
+
+void Server::setReceiveBatchSize(int receiveBatchSize)
+{
+    d->receiveBatchSize.storeRelease(qBound(1, receiveBatchSize, 1024));
+}
+
+quint64 Server::droppedDatagrams() const
+{
+    return d->statistics.counter(Statistics::DroppedDatagrams);
+}
+
+Statistics Server::statistics() const
+{
+    // The responder keeps its own counters since it may be used with any
+    // implementation of AbstractServer
+    Statistics statistics = d->statistics.snapshot();
+    Responder *responder = findChild<Responder*>(QString(), Qt::FindDirectChildrenOnly);
+    if (responder) {
+        responder->collectStatistics(statistics);
+    }
+    return statistics;
+}
+
+bool Server::histogramsEnabled() const
+{
+    return d->statistics.histogramsEnabled.loadAcquire();
+}
+
+void Server::setHistogramsEnabled(bool histogramsEnabled)
+{
+    d->statistics.histogramsEnabled.storeRelease(histogramsEnabled);
+}
+
+int Server::maxPacketSize() const
+{
+    return d->maxPacketSize.loadAcquire();
+}
+
+void Server::setMaxPacketSize(int maxPacketSize)
+{
+    d->maxPacketSize.storeRelease(qBound(512, maxPacketSize, MaxDatagramSize));
+}
+
+int Server::sendBatchDelay() const
+{
+    return d->sendBatchDelay.loadAcquire();
+}
+
+void Server::setSendBatchDelay(int sendBatchDelay)
+{
+    d->sendBatchDelay.storeRelease(qMax(0, sendBatchDelay));
+}
+
+int Server::duplicateWindow() const
+{
+    return d->duplicateWindow.loadAcquire();
+}
+
+void Server::setDuplicateWindow(int duplicateWindow)
+{
+    d->duplicateWindow.storeRelease(qMax(0, duplicateWindow));
+}
+
+bool Server::duplicateIgnoresSource() const
+{
+    return d->duplicateIgnoresSource.loadAcquire();
+}
+
+void Server::setDuplicateIgnoresSource(bool duplicateIgnoresSource)
+{
+    d->duplicateIgnoresSource.storeRelease(duplicateIgnoresSource);
+}
+
+bool Server::ownMessagesDelivered() const
+{
+    return d->ownMessagesDelivered.loadAcquire();
+}
+
+void Server::setOwnMessagesDelivered(bool ownMessagesDelivered)
+{
+    d->ownMessagesDelivered.storeRelease(ownMessagesDelivered);
+}
+
+void Server::sendMessage(const Message &message)
+{
+    d->sendMessage(message, false);
 }
 
 void Server::sendMessageToAll(const Message &message)
 {
-    QByteArray packet;
-    toPacket(message, packet);
-    d->ipv4Socket.writeDatagram(packet, MdnsIpv4Address, MdnsPort);
-    d->ipv6Socket.writeDatagram(packet, MdnsIpv6Address, MdnsPort);
+    d->sendMessage(message, true);
 }
@@ -25,16 +25,23 @@
 #ifndef QMDNSENGINE_SERVER_P_H
 #define QMDNSENGINE_SERVER_P_H
 
+#include <QAtomicInt>
+#include <QMutex>
 #include <QObject>
-#include <QTimer>
-#include <QUdpSocket>
 
-class QHostAddress;
+#include <qmdnsengine/interfacefilter.h>
+#include <qmdnsengine/message.h>
+
+#include "lockfreequeue_p.h"
+#include "statistics_p.h"
+
+class QThread;
 
 namespace QMdnsEngine
 {
 
 class Server;
+class ServerWorker;
 
 class ServerPrivate : public QObject
 {
@@ -43,17 +50,36 @@ class ServerPrivate : public QObject
 public:
 
     explicit ServerPrivate(Server *server);
+    virtual ~ServerPrivate();
+
+    void createWorker(bool threaded);
+    void destroyWorker();
+
+    void deliverMessage(const Message &message);
+    void sendMessage(const Message &message, bool all);
+
+    InterfaceFilter interfaceFilter();
+
+    // Settings are read by the worker, which may be in another thread
+    QAtomicInt receiveBatchSize;
+    QAtomicInt maxPacketSize;
+    QAtomicInt sendBatchDelay;
+    QAtomicInt duplicateWindow;
+    QAtomicInt duplicateIgnoresSource;
+    QAtomicInt ownMessagesDelivered;
+    StatisticsRecorder statistics;
 
-    bool bindSocket(QUdpSocket &socket, const QHostAddress &address);
+    // The filter is copied by the worker whenever it scans the interfaces
+    QMutex filterMutex;
+    InterfaceFilter filter;
 
-    QTimer timer;
-    QUdpSocket ipv4Socket;
-    QUdpSocket ipv6Socket;
+    ServerWorker *worker;
+    QThread *thread;
+    LockFreeQueue<Message> incoming;
 
-private Q_SLOTS:
+public Q_SLOTS:
 
-    void onTimeout();
-    void onReadyRead();
+    void onMessagesQueued();
 
 private:
 
@@ -0,0 +1,903 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QtGlobal>
+#if(QT_VERSION >= QT_VERSION_CHECK(5, 8, 0))
+#include <QNetworkDatagram>
+#define USE_NETWORKDATAGRAM
+#endif
+
+#ifdef Q_OS_UNIX
+#  include <cerrno>
+#  include <cstring>
+#  include <sys/socket.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#  include <linux/netlink.h>
+#  include <linux/rtnetlink.h>
+#  include <netinet/in.h>
+#  include <sys/uio.h>
+#  include <unistd.h>
+#endif
+
+#include <QHostAddress>
+#include <QNetworkInterface>
+#include <QSocketNotifier>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+
+#include "server_p.h"
+#include "serverworker_p.h"
+
+using namespace QMdnsEngine;
+
+// Largest number of packets handed to the kernel with a single system call
+const int MaxSendBatch = 64;
+
+// Time in milliseconds a multicast packet that was sent is remembered (in
+// addition to the time it may spend in the queue) to recognise it when it
+// is looped back
+const int OwnPacketWindow = 1000;
+
+// Changes to the interfaces tend to arrive in bursts (a new interface is
+// followed by its addresses), so they are collected for a moment before the
+// interfaces are scanned
+const int RescanDelay = 100;
+
+#ifdef Q_OS_LINUX
+// Space for the dropped packet counter and the packet information (which
+// includes the interface index) delivered with each datagram
+const int ControlSize = CMSG_SPACE(sizeof(quint32)) + CMSG_SPACE(sizeof(in6_pktinfo));
+
+// Space for the packet information selecting the interface of a datagram
+const int SendControlSize = CMSG_SPACE(sizeof(in6_pktinfo));
+
+// Fill in the socket address for a destination; link-local destinations
+// use the scope of the address if it has one, or else the interface
+static socklen_t toSockaddr(const QHostAddress &address, quint16 port, int interfaceIndex,
+        sockaddr_storage &storage)
+{
+    memset(&storage, 0, sizeof(sockaddr_storage));
+    if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+        sockaddr_in *in = reinterpret_cast<sockaddr_in*>(&storage);
+        in->sin_family = AF_INET;
+        in->sin_port = htons(port);
+        in->sin_addr.s_addr = htonl(address.toIPv4Address());
+        return sizeof(sockaddr_in);
+    }
+    sockaddr_in6 *in6 = reinterpret_cast<sockaddr_in6*>(&storage);
+    in6->sin6_family = AF_INET6;
+    in6->sin6_port = htons(port);
+    const Q_IPV6ADDR ipv6Addr = address.toIPv6Address();
+    memcpy(&in6->sin6_addr, &ipv6Addr, sizeof(Q_IPV6ADDR));
+    bool ok;
+    uint scope = address.scopeId().toUInt(&ok);
+    if (!ok) {
+        scope = QNetworkInterface::interfaceIndexFromName(address.scopeId());
+    }
+    in6->sin6_scope_id = scope ? scope : interfaceIndex;
+    return sizeof(sockaddr_in6);
+}
+
+// Retrieve the address and port of the sender of a datagram
+static void fromSockaddr(const sockaddr_storage &storage, QHostAddress &address, quint16 &port)
+{
+    address.setAddress(reinterpret_cast<const sockaddr*>(&storage));
+    port = ntohs(storage.ss_family == AF_INET6 ?
+        reinterpret_cast<const sockaddr_in6*>(&storage)->sin6_port :
+        reinterpret_cast<const sockaddr_in*>(&storage)->sin_port);
+}
+#endif
+
+ServerWorker::ServerWorker(ServerPrivate *server, bool threaded)
+    : QObject(threaded ? nullptr : server),
+      server(server),
+      threaded(threaded),
+      timer(this),
+      rescanTimer(this),
+      flushTimer(this),
+      ipv4Socket(this),
+      ipv6Socket(this),
+      ipv4Enabled(true),
+      ipv6Enabled(true),
+      filtering(false)
+#ifdef Q_OS_LINUX
+      ,
+      netlinkSocket(-1),
+      netlinkNotifier(nullptr),
+      ipv4Overflow(0),
+      ipv6Overflow(0)
+#endif
+{
+    connect(&timer, &QTimer::timeout, this, &ServerWorker::onTimeout);
+    connect(&rescanTimer, &QTimer::timeout, this, &ServerWorker::onRescanTimeout);
+    connect(&flushTimer, &QTimer::timeout, this, &ServerWorker::onFlushTimeout);
+    connect(&ipv4Socket, &QUdpSocket::readyRead, this, &ServerWorker::onReadyRead);
+    connect(&ipv6Socket, &QUdpSocket::readyRead, this, &ServerWorker::onReadyRead);
+
+    timer.setInterval(60 * 1000);
+    timer.setSingleShot(true);
+
+    rescanTimer.setInterval(RescanDelay);
+    rescanTimer.setSingleShot(true);
+
+    flushTimer.setSingleShot(true);
+    flushTimer.setTimerType(Qt::PreciseTimer);
+}
+
+ServerWorker::~ServerWorker()
+{
+    // Messages and packets still waiting to be sent are sent before the
+    // sockets close - in the I/O thread, this runs once the thread finishes
+    onMessagesQueued();
+    flush();
+
+#ifdef Q_OS_LINUX
+    if (netlinkSocket != -1) {
+        delete netlinkNotifier;
+        close(netlinkSocket);
+    }
+#endif
+}
+
+void ServerWorker::sendMessage(const Message &message)
+{
+    // Each packet is written into the same buffer and sent from there
+    const bool ipv4 = message.address().protocol() == QAbstractSocket::IPv4Protocol;
+    if (!(ipv4 ? ipv4Enabled : ipv6Enabled)) {
+        return;
+    }
+    QVector<Packet> &queue = ipv4 ? ipv4Queue : ipv6Queue;
+    writer.start(message, server->maxPacketSize.loadAcquire());
+    while (writer.writePacket()) {
+        queuePacket(queue, storePacket(message.address().isMulticast()), message.address(),
+                message.port(), message.interfaceIndex());
+    }
+}
+
+void ServerWorker::sendMessageToAll(const Message &message)
+{
+    // Each packet is written and stored once and then queued for every
+    // interface
+    writer.start(message, server->maxPacketSize.loadAcquire());
+    while (writer.writePacket()) {
+        const int offset = storePacket(true);
+        if (ipv4Enabled) {
+            sendToAll(ipv4Queue, MdnsIpv4Address, ipv4Interfaces, message.interfaceIndex(), offset);
+        }
+        if (ipv6Enabled) {
+            sendToAll(ipv6Queue, MdnsIpv6Address, ipv6Interfaces, message.interfaceIndex(), offset);
+        }
+    }
+}
+
+void ServerWorker::start()
+{
+    // The sockets are bound (and the interfaces watched) in the thread that
+    // reads from them
+#ifdef Q_OS_LINUX
+    openNetlink();
+#endif
+    onTimeout();
+}
+
+bool ServerWorker::bindSocket(QUdpSocket &socket, const QHostAddress &address)
+{
+    // Exit early if the socket is already bound
+    if (socket.state() == QAbstractSocket::BoundState) {
+        return true;
+    }
+
+    // I cannot find the correct combination of flags that allows the socket
+    // to bind properly on Linux, so on that platform, we must manually create
+    // the socket and initialize the QUdpSocket with it
+
+#ifdef Q_OS_UNIX
+    if (!socket.bind(address, MdnsPort, QAbstractSocket::ShareAddress)) {
+        int arg = 1;
+        if (setsockopt(socket.socketDescriptor(), SOL_SOCKET, SO_REUSEADDR,
+                reinterpret_cast<char*>(&arg), sizeof(int))) {
+            emit error(strerror(errno));
+            return false;
+        }
+#endif
+        if (!socket.bind(address, MdnsPort, QAbstractSocket::ReuseAddressHint)) {
+            emit error(socket.errorString());
+            return false;
+        }
+#ifdef Q_OS_UNIX
+    }
+#endif
+
+#ifdef Q_OS_LINUX
+    // Have the kernel report the interface that each datagram arrived on,
+    // since datagrams are read directly from the socket
+    int packetInfo = 1;
+    if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+        setsockopt(socket.socketDescriptor(), IPPROTO_IP, IP_PKTINFO,
+                reinterpret_cast<char*>(&packetInfo), sizeof(int));
+    } else {
+        setsockopt(socket.socketDescriptor(), IPPROTO_IPV6, IPV6_RECVPKTINFO,
+                reinterpret_cast<char*>(&packetInfo), sizeof(int));
+    }
+#endif
+
+#ifdef Q_OS_LINUX
+    // Only deliver datagrams for the groups joined by this socket, rather
+    // than those joined by any socket on the system, so that interfaces
+    // excluded by the filter stay silent
+    int multicastAll = 0;
+#  ifdef IP_MULTICAST_ALL
+    if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+        setsockopt(socket.socketDescriptor(), IPPROTO_IP, IP_MULTICAST_ALL,
+                reinterpret_cast<char*>(&multicastAll), sizeof(int));
+    }
+#  endif
+#  ifdef IPV6_MULTICAST_ALL
+    if (address.protocol() == QAbstractSocket::IPv6Protocol) {
+        setsockopt(socket.socketDescriptor(), IPPROTO_IPV6, IPV6_MULTICAST_ALL,
+                reinterpret_cast<char*>(&multicastAll), sizeof(int));
+    }
+#  endif
+    Q_UNUSED(multicastAll);
+#endif
+
+#if defined(Q_OS_LINUX) && defined(SO_RXQ_OVFL)
+    // Have the kernel report the number of datagrams dropped because the
+    // receive buffer was full alongside each datagram that is received
+    int overflow = 1;
+    setsockopt(socket.socketDescriptor(), SOL_SOCKET, SO_RXQ_OVFL,
+            reinterpret_cast<char*>(&overflow), sizeof(int));
+#endif
+
+    return true;
+}
+
+void ServerWorker::onTimeout()
+{
+    // A timer is used to run a set of operations once per minute; first, the
+    // two sockets are bound - if this fails, another attempt is made once per
+    // timeout; secondly, the interfaces are scanned and the sockets join the
+    // mDNS multicast groups on them; if the kernel reports changes to the
+    // interfaces, the timer is only needed until both sockets are bound
+
+    const InterfaceFilter filter = server->interfaceFilter();
+    ipv4Enabled = filter.acceptsProtocol(QAbstractSocket::IPv4Protocol);
+    ipv6Enabled = filter.acceptsProtocol(QAbstractSocket::IPv6Protocol);
+    bool ipv4Bound = prepareSocket(ipv4Socket, QHostAddress::AnyIPv4, ipv4Enabled, ipv4Joined);
+    bool ipv6Bound = prepareSocket(ipv6Socket, QHostAddress::AnyIPv6, ipv6Enabled, ipv6Joined);
+
+    bool watching = false;
+#ifdef Q_OS_LINUX
+    watching = netlinkSocket != -1;
+#endif
+
+    // Without notifications, an interface may have been removed and added
+    // again since the last scan, so the groups are joined on every interface
+    if (!watching) {
+        ipv4Joined.clear();
+        ipv6Joined.clear();
+    }
+    rescan();
+
+    if (!watching || !ipv4Bound || !ipv6Bound) {
+        timer.start();
+    }
+}
+
+void ServerWorker::onRescanTimeout()
+{
+    rescan();
+}
+
+void ServerWorker::onFlushTimeout()
+{
+    flush();
+}
+
+bool ServerWorker::prepareSocket(QUdpSocket &socket, const QHostAddress &address, bool enabled,
+        QHash<int, QNetworkInterface> &joined)
+{
+    // The socket for a protocol excluded by the filter is closed, which also
+    // drops its memberships; it is not retried
+    if (enabled) {
+        return bindSocket(socket, address);
+    }
+    if (socket.state() == QAbstractSocket::BoundState) {
+        socket.close();
+        joined.clear();
+    }
+    return true;
+}
+
+void ServerWorker::rescan()
+{
+    // Rebuild the address table shared with the rest of the process, apply
+    // the filter of the server to its interfaces and bring the group
+    // memberships in line with the result; a change is reported unless this
+    // is the first scan, but only if it affects the interfaces in use
+    const bool scanned = !addresses.isNull();
+    addresses = AddressTable::refresh();
+
+    const InterfaceFilter filter = server->interfaceFilter();
+    const auto interfaces = addresses->interfaces();
+    acceptedInterfaces.clear();
+    for (const QNetworkInterface &networkInterface : interfaces) {
+        if (filter.acceptsInterface(networkInterface)) {
+            acceptedInterfaces.insert(networkInterface.index());
+        }
+    }
+    filtering = acceptedInterfaces.count() != interfaces.count();
+    ipv4Interfaces.clear();
+    ipv6Interfaces.clear();
+    const auto ipv4Multicast = addresses->multicastInterfaces(QAbstractSocket::IPv4Protocol);
+    for (int index : ipv4Multicast) {
+        if (acceptedInterfaces.contains(index)) {
+            ipv4Interfaces.append(index);
+        }
+    }
+    const auto ipv6Multicast = addresses->multicastInterfaces(QAbstractSocket::IPv6Protocol);
+    for (int index : ipv6Multicast) {
+        if (acceptedInterfaces.contains(index)) {
+            ipv6Interfaces.append(index);
+        }
+    }
+
+    updateGroups(ipv4Socket, MdnsIpv4Address, ipv4Interfaces, ipv4Joined);
+    updateGroups(ipv6Socket, MdnsIpv6Address, ipv6Interfaces, ipv6Joined);
+    const AddressTable::InterfaceAddresses used = addresses->usedAddresses(filter);
+    const bool changed = scanned && used != usedAddresses;
+    usedAddresses = used;
+    if (changed) {
+        emit interfacesChanged();
+    }
+}
+
+void ServerWorker::updateGroups(QUdpSocket &socket, const QHostAddress &group,
+        const QList<int> &interfaces, QHash<int, QNetworkInterface> &joined)
+{
+    if (socket.state() != QAbstractSocket::BoundState) {
+        return;
+    }
+
+    // Leave the group on interfaces that can no longer be used and join it
+    // on new ones - interfaces that have not changed are left alone
+    for (auto i = joined.begin(); i != joined.end();) {
+        if (!interfaces.contains(i.key())) {
+            socket.leaveMulticastGroup(group, i.value());
+            i = joined.erase(i);
+        } else {
+            ++i;
+        }
+    }
+    for (int index : interfaces) {
+        if (!joined.contains(index)) {
+            const QNetworkInterface networkInterface = addresses->networkInterface(index);
+            if (socket.joinMulticastGroup(group, networkInterface)) {
+                joined.insert(index, networkInterface);
+            }
+        }
+    }
+}
+
+void ServerWorker::readDatagram(QUdpSocket *socket)
+{
+    // The buffer is reused for every datagram; datagrams too large for an
+    // mDNS message are discarded and counted as they are in batches
+    if (buffer.size() != MaxDatagramSize) {
+        buffer.resize(MaxDatagramSize);
+    }
+
+#ifdef Q_OS_LINUX
+    // The datagram is peeked at, along with the interface it arrived on,
+    // and then consumed through the socket, since that is what re-enables
+    // its read notification
+    sockaddr_storage storage;
+    iovec vector = {buffer.data(), static_cast<size_t>(MaxDatagramSize)};
+    alignas(cmsghdr) char control[ControlSize];
+    msghdr header;
+    memset(&header, 0, sizeof(msghdr));
+    header.msg_name = &storage;
+    header.msg_namelen = sizeof(sockaddr_storage);
+    header.msg_iov = &vector;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = ControlSize;
+    ssize_t length = recvmsg(socket->socketDescriptor(), &header, MSG_PEEK | MSG_DONTWAIT);
+    socket->readDatagram(nullptr, 0);
+    if (length < 0) {
+        return;
+    }
+    const int interfaceIndex = parseControl(socket, header);
+    if (header.msg_flags & MSG_TRUNC) {
+        server->statistics.add(Statistics::DroppedDatagrams);
+        return;
+    }
+    QHostAddress address;
+    quint16 port;
+    fromSockaddr(storage, address, port);
+    processDatagram(QByteArray::fromRawData(buffer.constData(), length), address, port, interfaceIndex);
+#else
+    if (socket->pendingDatagramSize() > MaxDatagramSize) {
+        socket->readDatagram(nullptr, 0);
+        server->statistics.add(Statistics::DroppedDatagrams);
+        return;
+    }
+#  ifdef USE_NETWORKDATAGRAM
+    // Qt only reports the interface a datagram arrived on along with a copy
+    // of its data, so the buffer cannot be used here
+    const QNetworkDatagram datagram = socket->receiveDatagram(MaxDatagramSize);
+    if (datagram.isValid()) {
+        processDatagram(datagram.data(), datagram.senderAddress(),
+                datagram.senderPort(), datagram.interfaceIndex());
+    }
+#  else
+    QHostAddress address;
+    quint16 port;
+    qint64 length = socket->readDatagram(buffer.data(), MaxDatagramSize, &address, &port);
+    if (length >= 0) {
+        processDatagram(QByteArray::fromRawData(buffer.constData(), length), address, port, 0);
+    }
+#  endif
+#endif
+}
+
+void ServerWorker::processDatagram(const QByteArray &packet, const QHostAddress &address,
+        quint16 port, int interfaceIndex)
+{
+    // Datagrams that arrive on an interface excluded by the filter are
+    // discarded without being decoded
+    if (filtering && interfaceIndex && !acceptedInterfaces.contains(interfaceIndex)) {
+        return;
+    }
+
+    server->statistics.add(Statistics::PacketsReceived);
+    server->statistics.add(Statistics::BytesReceived, packet.length());
+    server->statistics.record(Statistics::PacketSize, packet.length());
+
+    // Packets sent by this server are recognised by their contents, which
+    // must also come from the mDNS port of a local address - a remote host
+    // may well send the very same query
+    if (port == MdnsPort && !server->ownMessagesDelivered.loadAcquire() &&
+            (!addresses || addresses->isLocalAddress(address)) &&
+            ownPackets.contains(packet, ownPacketWindow())) {
+        server->statistics.add(Statistics::OwnPacketsDropped);
+        return;
+    }
+
+    // Copies of a datagram received shortly before are dropped before they
+    // are decoded; the datagrams remembered are forgotten once disabled
+    const int window = server->duplicateWindow.loadAcquire();
+    if (window) {
+        if (duplicates.isDuplicate(packet, address, port,
+                server->duplicateIgnoresSource.loadAcquire(), window)) {
+            server->statistics.add(Statistics::DuplicateHits);
+            return;
+        }
+        server->statistics.add(Statistics::DuplicateMisses);
+    } else {
+        duplicates.clear();
+    }
+
+    // Attempt to decode the packet
+    Message message;
+    if (!fromPacket(packet, message)) {
+        server->statistics.add(Statistics::ParseFailures);
+        return;
+    }
+    message.setAddress(address);
+    message.setPort(port);
+    message.setInterfaceIndex(interfaceIndex);
+
+    // In the I/O thread, the message is queued for the thread of the server,
+    // which is only notified when the queue was empty so that messages
+    // received in a burst are delivered together
+    if (!threaded) {
+        server->deliverMessage(message);
+    } else if (server->incoming.push(message)) {
+        QMetaObject::invokeMethod(server, "onMessagesQueued", Qt::QueuedConnection);
+    }
+}
+
+void ServerWorker::sendToAll(QVector<Packet> &queue, const QHostAddress &address,
+        const QList<int> &interfaces, int interfaceIndex, int offset)
+{
+    // A message for a single interface is only sent if the interface is
+    // used for the protocol; until the interfaces are known, the system
+    // chooses the interface
+    if (!addresses) {
+        queuePacket(queue, offset, address, MdnsPort, interfaceIndex);
+    } else if (interfaceIndex) {
+        if (interfaces.contains(interfaceIndex)) {
+            queuePacket(queue, offset, address, MdnsPort, interfaceIndex);
+        }
+    } else {
+        for (int index : interfaces) {
+            queuePacket(queue, offset, address, MdnsPort, index);
+        }
+    }
+}
+
+int ServerWorker::storePacket(bool multicast)
+{
+    // Multicast packets come back through multicast loopback and are
+    // remembered so that they can be dropped when received
+    if (multicast && !server->ownMessagesDelivered.loadAcquire()) {
+        ownPackets.insert(writer.data(), writer.size(), ownPacketWindow());
+    }
+    const int offset = queueData.size();
+    queueData.append(writer.data(), writer.size());
+    return offset;
+}
+
+int ServerWorker::ownPacketWindow() const
+{
+    return OwnPacketWindow + (server->sendBatchDelay.loadAcquire() + 999) / 1000;
+}
+
+void ServerWorker::queuePacket(QVector<Packet> &queue, int offset, const QHostAddress &address,
+        quint16 port, int interfaceIndex)
+{
+    // Packets are sent together once control returns to the event loop or,
+    // if a delay is set, once the delay has passed
+    queue.append({offset, writer.size(), address, port, interfaceIndex});
+    if (!flushTimer.isActive()) {
+        const int delay = server->sendBatchDelay.loadAcquire();
+        flushTimer.start((delay + 999) / 1000);
+    }
+}
+
+void ServerWorker::flush()
+{
+    const int count = ipv4Queue.count() + ipv6Queue.count();
+    if (!count) {
+        return;
+    }
+    flushQueue(ipv4Socket, ipv4Queue);
+    flushQueue(ipv6Socket, ipv6Queue);
+    ipv4Queue.clear();
+    ipv6Queue.clear();
+    queueData.clear();
+
+    server->statistics.add(Statistics::SendFlushes);
+    server->statistics.record(Statistics::PacketsPerFlush, count);
+}
+
+void ServerWorker::flushQueue(QUdpSocket &socket, const QVector<Packet> &queue)
+{
+#ifdef Q_OS_LINUX
+    // On Linux, the packets are sent in batches with a single system call
+    // per batch once the socket exists
+    if (socket.socketDescriptor() != -1) {
+        sendBatches(socket, queue);
+        return;
+    }
+#endif
+    for (const Packet &packet : queue) {
+        sendPacket(socket, packet);
+    }
+}
+
+void ServerWorker::sendPacket(QUdpSocket &socket, const Packet &packet)
+{
+    const char *data = queueData.constData() + packet.offset;
+#ifdef USE_NETWORKDATAGRAM
+    // The interface is passed along with the datagram rather than changing
+    // the multicast interface of the socket for every packet
+    QNetworkDatagram datagram(QByteArray::fromRawData(data, packet.length), packet.address, packet.port);
+    if (packet.interfaceIndex) {
+        datagram.setInterfaceIndex(packet.interfaceIndex);
+    }
+    qint64 sent = socket.writeDatagram(datagram);
+#else
+    if (packet.address.isMulticast()) {
+        socket.setMulticastInterface(QNetworkInterface::interfaceFromIndex(packet.interfaceIndex));
+    }
+    qint64 sent = socket.writeDatagram(data, packet.length, packet.address, packet.port);
+#endif
+    if (sent >= 0) {
+        server->statistics.add(Statistics::PacketsSent);
+        server->statistics.add(Statistics::BytesSent, packet.length);
+    }
+}
+
+#ifdef Q_OS_LINUX
+
+bool ServerWorker::openNetlink()
+{
+    // Subscribe to the notifications sent by the kernel when links and
+    // addresses are added, removed or changed; if this fails, the interfaces
+    // are scanned once per minute instead
+    int fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (fd == -1) {
+        return false;
+    }
+    sockaddr_nl address;
+    memset(&address, 0, sizeof(sockaddr_nl));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(sockaddr_nl))) {
+        ::close(fd);
+        return false;
+    }
+    netlinkSocket = fd;
+
+    // The signal of the notifier changed in Qt 5.15, so the connection is
+    // made by name
+    netlinkNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+#if(QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+    connect(netlinkNotifier, SIGNAL(activated(QSocketDescriptor,QSocketNotifier::Type)),
+            this, SLOT(onNetlinkActivated()));
+#else
+    connect(netlinkNotifier, SIGNAL(activated(int)), this, SLOT(onNetlinkActivated()));
+#endif
+    return true;
+}
+
+#endif
+
+void ServerWorker::onNetlinkActivated()
+{
+#ifdef Q_OS_LINUX
+    // Read every pending notification; the kernel drops the memberships of
+    // a link when it is removed, so those are forgotten right away in case
+    // the link returns before the scan - if notifications were lost, every
+    // group is joined again
+    alignas(nlmsghdr) char data[8192];
+    forever {
+        ssize_t length = recv(netlinkSocket, data, sizeof(data), MSG_DONTWAIT);
+        if (length < 0 && errno == ENOBUFS) {
+            ipv4Joined.clear();
+            ipv6Joined.clear();
+            continue;
+        }
+        if (length <= 0) {
+            break;
+        }
+        int remaining = static_cast<int>(length);
+        for (const nlmsghdr *header = reinterpret_cast<const nlmsghdr*>(data);
+                NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+            if (header->nlmsg_type == RTM_DELLINK) {
+                const ifinfomsg *info = reinterpret_cast<const ifinfomsg*>(NLMSG_DATA(header));
+                ipv4Joined.remove(info->ifi_index);
+                ipv6Joined.remove(info->ifi_index);
+            }
+        }
+    }
+
+    // Wait for the burst of notifications to end before scanning
+    if (!rescanTimer.isActive()) {
+        rescanTimer.start();
+    }
+#endif
+}
+
+#ifdef Q_OS_LINUX
+
+void ServerWorker::sendBatches(QUdpSocket &socket, const QVector<Packet> &queue)
+{
+    // Allocate storage for a batch - as with receiving, the buffers are
+    // reused for every batch
+    if (sendHeaders.isEmpty()) {
+        sendControl.resize(MaxSendBatch * SendControlSize);
+        sendHeaders.resize(MaxSendBatch);
+        sendVectors.resize(MaxSendBatch);
+        sendAddresses.resize(MaxSendBatch);
+    }
+
+    for (int start = 0; start < queue.count();) {
+        const int count = qMin(queue.count() - start, MaxSendBatch);
+        for (int i = 0; i < count; ++i) {
+            const Packet &packet = queue.at(start + i);
+            sendVectors[i].iov_base = const_cast<char*>(queueData.constData() + packet.offset);
+            sendVectors[i].iov_len = packet.length;
+            msghdr &header = sendHeaders[i].msg_hdr;
+            memset(&header, 0, sizeof(msghdr));
+            header.msg_name = &sendAddresses[i];
+            header.msg_namelen = toSockaddr(packet.address, packet.port,
+                    packet.interfaceIndex, sendAddresses[i]);
+            header.msg_iov = &sendVectors[i];
+            header.msg_iovlen = 1;
+
+            // The interface is selected with packet information in the same
+            // way as QNetworkDatagram does
+            if (!packet.interfaceIndex) {
+                continue;
+            }
+            header.msg_control = sendControl.data() + i * SendControlSize;
+            memset(header.msg_control, 0, SendControlSize);
+            if (packet.address.protocol() == QAbstractSocket::IPv4Protocol) {
+                header.msg_controllen = CMSG_SPACE(sizeof(in_pktinfo));
+                cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+                cmsg->cmsg_level = IPPROTO_IP;
+                cmsg->cmsg_type = IP_PKTINFO;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(in_pktinfo));
+                in_pktinfo info;
+                memset(&info, 0, sizeof(in_pktinfo));
+                info.ipi_ifindex = packet.interfaceIndex;
+                memcpy(CMSG_DATA(cmsg), &info, sizeof(in_pktinfo));
+            } else {
+                header.msg_controllen = CMSG_SPACE(sizeof(in6_pktinfo));
+                cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+                cmsg->cmsg_level = IPPROTO_IPV6;
+                cmsg->cmsg_type = IPV6_PKTINFO;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(in6_pktinfo));
+                in6_pktinfo info;
+                memset(&info, 0, sizeof(in6_pktinfo));
+                info.ipi6_ifindex = packet.interfaceIndex;
+                memcpy(CMSG_DATA(cmsg), &info, sizeof(in6_pktinfo));
+            }
+        }
+
+        // If the first packet of a batch cannot be sent, it is skipped so
+        // that one unreachable destination does not hold up the rest; if the
+        // socket buffer is full, the remaining packets are dropped
+        int sent = sendmmsg(socket.socketDescriptor(), sendHeaders.data(), count, MSG_DONTWAIT);
+        if (sent <= 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            ++start;
+            continue;
+        }
+        for (int i = 0; i < sent; ++i) {
+            server->statistics.add(Statistics::PacketsSent);
+            server->statistics.add(Statistics::BytesSent, queue.at(start + i).length);
+        }
+        start += sent;
+    }
+}
+
+void ServerWorker::readBatches(QUdpSocket *socket)
+{
+    const int batchSize = server->receiveBatchSize.loadAcquire();
+
+    // Allocate storage for the batch - this is only done when the batch size
+    // changes since the buffers are reused for every batch
+    if (batchHeaders.size() != batchSize) {
+        batchBuffer.resize(batchSize * MaxDatagramSize);
+        batchControl.resize(batchSize * ControlSize);
+        batchHeaders.resize(batchSize);
+        batchVectors.resize(batchSize);
+        batchAddresses.resize(batchSize);
+    }
+
+    // Keep reading until a batch comes back partially filled, indicating
+    // that no more datagrams are waiting
+    forever {
+        for (int i = 0; i < batchSize; ++i) {
+            batchVectors[i].iov_base = batchBuffer.data() + i * MaxDatagramSize;
+            batchVectors[i].iov_len = MaxDatagramSize;
+            msghdr &header = batchHeaders[i].msg_hdr;
+            memset(&header, 0, sizeof(msghdr));
+            header.msg_name = &batchAddresses[i];
+            header.msg_namelen = sizeof(sockaddr_storage);
+            header.msg_iov = &batchVectors[i];
+            header.msg_iovlen = 1;
+            header.msg_control = batchControl.data() + i * ControlSize;
+            header.msg_controllen = ControlSize;
+        }
+        int count = recvmmsg(socket->socketDescriptor(), batchHeaders.data(),
+                batchSize, MSG_DONTWAIT, nullptr);
+        if (count <= 0) {
+            break;
+        }
+        for (int i = 0; i < count; ++i) {
+            const msghdr &header = batchHeaders.at(i).msg_hdr;
+            const int interfaceIndex = parseControl(socket, header);
+
+            // Datagrams too large for an mDNS message are discarded
+            if (header.msg_flags & MSG_TRUNC) {
+                server->statistics.add(Statistics::DroppedDatagrams);
+                continue;
+            }
+
+            QHostAddress address;
+            quint16 port;
+            fromSockaddr(batchAddresses.at(i), address, port);
+            processDatagram(QByteArray::fromRawData(
+                batchBuffer.constData() + i * MaxDatagramSize,
+                batchHeaders.at(i).msg_len
+            ), address, port, interfaceIndex);
+        }
+        if (count < batchSize) {
+            break;
+        }
+    }
+}
+
+int ServerWorker::parseControl(QUdpSocket *socket, const msghdr &header)
+{
+    // The kernel reports the total number of datagrams dropped by the
+    // socket so far - the difference is added to the count of dropped
+    // datagrams - and the index of the interface the datagram arrived on
+    int interfaceIndex = 0;
+    for (const cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg;
+            cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&header), const_cast<cmsghdr*>(cmsg))) {
+#ifdef SO_RXQ_OVFL
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+            quint32 overflow;
+            memcpy(&overflow, CMSG_DATA(cmsg), sizeof(quint32));
+            quint32 &previous = socket == &ipv4Socket ? ipv4Overflow : ipv6Overflow;
+            server->statistics.add(Statistics::DroppedDatagrams, overflow - previous);
+            previous = overflow;
+        }
+#endif
+        if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO) {
+            in_pktinfo info;
+            memcpy(&info, CMSG_DATA(cmsg), sizeof(in_pktinfo));
+            interfaceIndex = info.ipi_ifindex;
+        } else if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO) {
+            in6_pktinfo info;
+            memcpy(&info, CMSG_DATA(cmsg), sizeof(in6_pktinfo));
+            interfaceIndex = info.ipi6_ifindex;
+        }
+    }
+#ifndef SO_RXQ_OVFL
+    Q_UNUSED(socket);
+#endif
+    return interfaceIndex;
+}
+
+#endif
+
+void ServerWorker::onReadyRead()
+{
+    // Drain every datagram waiting on the socket; the first is always read
+    // through the socket itself, since that is what re-enables its read
+    // notification
+    QUdpSocket *socket = qobject_cast<QUdpSocket*>(sender());
+    if (!socket->hasPendingDatagrams()) {
+        return;
+    }
+    readDatagram(socket);
+
+#ifdef Q_OS_LINUX
+    // On Linux, the remaining datagrams are read in batches with a single
+    // system call per batch
+    if (server->receiveBatchSize.loadAcquire() > 1) {
+        readBatches(socket);
+        return;
+    }
+#endif
+
+    while (socket->hasPendingDatagrams()) {
+        readDatagram(socket);
+    }
+}
+
+void ServerWorker::onMessagesQueued()
+{
+    const auto messages = outgoing.takeAll();
+    for (const Outgoing &message : messages) {
+        if (message.all) {
+            sendMessageToAll(message.message);
+        } else {
+            sendMessage(message.message);
+        }
+    }
+}
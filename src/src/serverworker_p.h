@@ -0,0 +1,192 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_SERVERWORKER_P_H
+#define QMDNSENGINE_SERVERWORKER_P_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QNetworkInterface>
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QVector>
+
+#ifdef Q_OS_LINUX
+#  include <sys/socket.h>
+#endif
+
+#include <qmdnsengine/message.h>
+
+#include "addresstable_p.h"
+#include "duplicatefilter_p.h"
+#include "lockfreequeue_p.h"
+#include "packetwriter_p.h"
+
+class QHostAddress;
+class QSocketNotifier;
+
+namespace QMdnsEngine
+{
+
+class ServerPrivate;
+
+// Largest mDNS message that can be received (RFC 6762, section 17)
+const int MaxDatagramSize = 9000;
+
+// Performs the socket I/O for a server - receiving and decoding messages and
+// encoding and sending them - either in the thread of the server or in an I/O
+// thread of its own, in which case messages are passed through queues
+class ServerWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    struct Outgoing
+    {
+        Message message;
+        bool all;
+    };
+
+    // Packet waiting to be sent, stored in the data of the queue
+    struct Packet
+    {
+        int offset;
+        int length;
+        QHostAddress address;
+        quint16 port;
+        int interfaceIndex;
+    };
+
+    ServerWorker(ServerPrivate *server, bool threaded);
+    virtual ~ServerWorker();
+
+    void sendMessage(const Message &message);
+    void sendMessageToAll(const Message &message);
+
+    LockFreeQueue<Outgoing> outgoing;
+
+Q_SIGNALS:
+
+    void error(const QString &message);
+    void interfacesChanged();
+
+public Q_SLOTS:
+
+    void start();
+
+private Q_SLOTS:
+
+    void onTimeout();
+    void onRescanTimeout();
+    void onFlushTimeout();
+    void onNetlinkActivated();
+    void onReadyRead();
+    void onMessagesQueued();
+
+private:
+
+    bool bindSocket(QUdpSocket &socket, const QHostAddress &address);
+    bool prepareSocket(QUdpSocket &socket, const QHostAddress &address, bool enabled,
+            QHash<int, QNetworkInterface> &joined);
+    void rescan();
+    void updateGroups(QUdpSocket &socket, const QHostAddress &group,
+            const QList<int> &interfaces, QHash<int, QNetworkInterface> &joined);
+
+    void readDatagram(QUdpSocket *socket);
+    void processDatagram(const QByteArray &packet, const QHostAddress &address,
+            quint16 port, int interfaceIndex);
+    void sendToAll(QVector<Packet> &queue, const QHostAddress &address,
+            const QList<int> &interfaces, int interfaceIndex, int offset);
+    int storePacket(bool multicast);
+    int ownPacketWindow() const;
+    void queuePacket(QVector<Packet> &queue, int offset, const QHostAddress &address,
+            quint16 port, int interfaceIndex);
+    void flush();
+    void flushQueue(QUdpSocket &socket, const QVector<Packet> &queue);
+    void sendPacket(QUdpSocket &socket, const Packet &packet);
+
+#ifdef Q_OS_LINUX
+    bool openNetlink();
+    void sendBatches(QUdpSocket &socket, const QVector<Packet> &queue);
+    void readBatches(QUdpSocket *socket);
+    int parseControl(QUdpSocket *socket, const msghdr &header);
+#endif
+
+    ServerPrivate *const server;
+    const bool threaded;
+
+    QTimer timer;
+    QTimer rescanTimer;
+    QTimer flushTimer;
+    QUdpSocket ipv4Socket;
+    QUdpSocket ipv6Socket;
+
+    // Interfaces found by the last scan and those allowed by the filter of
+    // the server - which multicast messages are sent on - and the interfaces
+    // that each socket has joined the group on
+    QSharedPointer<const AddressTable> addresses;
+    bool ipv4Enabled;
+    bool ipv6Enabled;
+    bool filtering;
+    QSet<int> acceptedInterfaces;
+    QList<int> ipv4Interfaces;
+    QList<int> ipv6Interfaces;
+    AddressTable::InterfaceAddresses usedAddresses;
+    QHash<int, QNetworkInterface> ipv4Joined;
+    QHash<int, QNetworkInterface> ipv6Joined;
+
+    DuplicateFilter duplicates;
+    DuplicateFilter ownPackets;
+    PacketWriter writer;
+    QByteArray buffer;
+
+    // Packets written since the queues were last flushed
+    QByteArray queueData;
+    QVector<Packet> ipv4Queue;
+    QVector<Packet> ipv6Queue;
+
+#ifdef Q_OS_LINUX
+    int netlinkSocket;
+    QSocketNotifier *netlinkNotifier;
+    QByteArray batchBuffer;
+    QByteArray batchControl;
+    QVector<mmsghdr> batchHeaders;
+    QVector<iovec> batchVectors;
+    QVector<sockaddr_storage> batchAddresses;
+    QByteArray sendControl;
+    QVector<mmsghdr> sendHeaders;
+    QVector<iovec> sendVectors;
+    QVector<sockaddr_storage> sendAddresses;
+    quint32 ipv4Overflow;
+    quint32 ipv6Overflow;
+#endif
+};
+
+}
+
+#endif // QMDNSENGINE_SERVERWORKER_P_H
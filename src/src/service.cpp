@@ -25,6 +25,7 @@
 #include <qmdnsengine/service.h>
 
 #include "service_p.h"
+#include "shareddata_p.h"
 
 using namespace QMdnsEngine;
 
@@ -38,19 +39,33 @@ Service::Service()
 }
 
 Service::Service(const Service &other)
-    : d(new ServicePrivate)
+    : d(other.d)
 {
-    *this = other;
 }
 
 Service &Service::operator=(const Service &other)
 {
-    *d = *other.d;
+    d = other.d;
+    return *this;
+}
+
+Service::Service(Service &&other) noexcept
+    : d(sharedNull<ServicePrivate>())
+{
+    d.swap(other.d);
+}
+
+Service &Service::operator=(Service &&other) noexcept
+{
+    d.swap(other.d);
     return *this;
 }
 
 bool Service::operator==(const Service &other) const
 {
+    if (d == other.d) {
+        return true;
+    }
     return d->type == other.d->type &&
         d->name == other.d->name &&
         d->port == other.d->port &&
@@ -64,7 +79,6 @@ bool Service::operator!=(const Service &other) const
 
 Service::~Service()
 {
-    delete d;
 }
 
 QByteArray Service::type() const
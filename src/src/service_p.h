@@ -27,11 +27,12 @@
 
 #include <QByteArray>
 #include <QMap>
+#include <QSharedData>
 
 namespace QMdnsEngine
 {
 
-class ServicePrivate
+class ServicePrivate : public QSharedData
 {
 public:
 
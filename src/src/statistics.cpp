@@ -0,0 +1,166 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#include <QtAlgorithms>
+#include <QtGlobal>
+#if(QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
+#define USE_LOADRELAXED
+#endif
+
+#include <qmdnsengine/statistics.h>
+
+#include "shareddata_p.h"
+#include "statistics_p.h"
+
+using namespace QMdnsEngine;
+
+template<class T>
+static quint64 loadRelaxed(const QAtomicInteger<T> &value)
+{
+#ifdef USE_LOADRELAXED
+    return value.loadRelaxed();
+#else
+    return value.load();
+#endif
+}
+
+StatisticsPrivate::StatisticsPrivate()
+{
+    std::memset(counters, 0, sizeof(counters));
+    std::memset(histograms, 0, sizeof(histograms));
+}
+
+StatisticsRecorder::StatisticsRecorder()
+    : histogramsEnabled(0)
+{
+}
+
+void StatisticsRecorder::add(Statistics::Counter counter, quint64 value)
+{
+    counters[counter].fetchAndAddRelaxed(value);
+}
+
+void StatisticsRecorder::subtract(Statistics::Counter counter, quint64 value)
+{
+    counters[counter].fetchAndSubRelaxed(value);
+}
+
+void StatisticsRecorder::record(Statistics::Histogram histogram, quint64 value)
+{
+    if (!histogramsEnabled.loadAcquire()) {
+        return;
+    }
+
+    // The bucket is the number of significant bits in the value
+    const int bucket = value ? 64 - qCountLeadingZeroBits(value) : 0;
+    histograms[histogram][qMin(bucket, Statistics::BucketCount - 1)].fetchAndAddRelaxed(1);
+}
+
+quint64 StatisticsRecorder::counter(Statistics::Counter counter) const
+{
+    return loadRelaxed(counters[counter]);
+}
+
+Statistics StatisticsRecorder::snapshot() const
+{
+    Statistics statistics;
+    collect(statistics);
+    return statistics;
+}
+
+void StatisticsRecorder::collect(Statistics &statistics) const
+{
+    // The values are added to those already in the snapshot, allowing the
+    // statistics of several recorders to be combined
+    StatisticsPrivate *d = statistics.d.data();
+    for (int i = 0; i < Statistics::CounterCount; ++i) {
+        d->counters[i] += loadRelaxed(counters[i]);
+    }
+    for (int i = 0; i < Statistics::HistogramCount; ++i) {
+        for (int j = 0; j < Statistics::BucketCount; ++j) {
+            d->histograms[i][j] += loadRelaxed(histograms[i][j]);
+        }
+    }
+}
+
+Statistics::Statistics()
+    : d(new StatisticsPrivate)
+{
+}
+
+Statistics::Statistics(const Statistics &other)
+    : d(other.d)
+{
+}
+
+Statistics &Statistics::operator=(const Statistics &other)
+{
+    d = other.d;
+    return *this;
+}
+
+Statistics::Statistics(Statistics &&other) noexcept
+    : d(sharedNull<StatisticsPrivate>())
+{
+    d.swap(other.d);
+}
+
+Statistics &Statistics::operator=(Statistics &&other) noexcept
+{
+    d.swap(other.d);
+    return *this;
+}
+
+Statistics &Statistics::operator+=(const Statistics &other)
+{
+    for (int i = 0; i < CounterCount; ++i) {
+        d->counters[i] += other.d->counters[i];
+    }
+    for (int i = 0; i < HistogramCount; ++i) {
+        for (int j = 0; j < BucketCount; ++j) {
+            d->histograms[i][j] += other.d->histograms[i][j];
+        }
+    }
+    return *this;
+}
+
+Statistics::~Statistics()
+{
+}
+
+quint64 Statistics::counter(Counter counter) const
+{
+    return d->counters[counter];
+}
+
+QVector<quint64> Statistics::histogram(Histogram histogram) const
+{
+    QVector<quint64> buckets(BucketCount);
+    for (int i = 0; i < BucketCount; ++i) {
+        buckets[i] = d->histograms[histogram][i];
+    }
+    return buckets;
+}
@@ -0,0 +1,73 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_STATISTICS_P_H
+#define QMDNSENGINE_STATISTICS_P_H
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QSharedData>
+
+#include <qmdnsengine/statistics.h>
+
+namespace QMdnsEngine
+{
+
+class StatisticsPrivate : public QSharedData
+{
+public:
+
+    StatisticsPrivate();
+
+    quint64 counters[Statistics::CounterCount];
+    quint64 histograms[Statistics::HistogramCount][Statistics::BucketCount];
+};
+
+// Counters kept by each class while it runs; updates are relaxed atomic
+// operations so that a snapshot can be taken from any thread without a lock
+class StatisticsRecorder
+{
+public:
+
+    StatisticsRecorder();
+
+    void add(Statistics::Counter counter, quint64 value = 1);
+    void subtract(Statistics::Counter counter, quint64 value = 1);
+    void record(Statistics::Histogram histogram, quint64 value);
+
+    quint64 counter(Statistics::Counter counter) const;
+    Statistics snapshot() const;
+    void collect(Statistics &statistics) const;
+
+    QAtomicInt histogramsEnabled;
+
+private:
+
+    QAtomicInteger<quint64> counters[Statistics::CounterCount];
+    QAtomicInteger<quint64> histograms[Statistics::HistogramCount][Statistics::BucketCount];
+};
+
+}
+
+#endif // QMDNSENGINE_STATISTICS_P_H
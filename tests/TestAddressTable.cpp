@@ -0,0 +1,219 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QHostAddress>
+#include <QNetworkAddressEntry>
+#include <QNetworkInterface>
+#include <QObject>
+#include <QPair>
+#include <QTest>
+
+#include <qmdnsengine/interfacefilter.h>
+
+#include "addresstable_p.h"
+
+class TestAddressTable : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void initTestCase();
+    void testShared();
+    void testLocalAddresses();
+    void testInterfaceIndex();
+    void testUnknownAddress();
+    void testMulticastInterfaces();
+    void testUsedAddresses();
+
+private:
+
+    bool inSubnetOf(const QHostAddress &address, int interfaceIndex) const;
+
+    QList<QNetworkInterface> interfaces;
+};
+
+void TestAddressTable::initTestCase()
+{
+    // The table is built from the interfaces of the host, so the tests
+    // compare its lookups against what Qt reports for them
+    interfaces = QNetworkInterface::allInterfaces();
+    bool hasAddress = false;
+    for (const QNetworkInterface &networkInterface : qAsConst(interfaces)) {
+        hasAddress |= !networkInterface.addressEntries().isEmpty();
+    }
+    if (!hasAddress) {
+        QSKIP("no network interfaces with addresses");
+    }
+}
+
+void TestAddressTable::testShared()
+{
+    // The current table is shared until it is refreshed
+    QSharedPointer<const QMdnsEngine::AddressTable> table = QMdnsEngine::AddressTable::current();
+    QVERIFY(!table.isNull());
+    QCOMPARE(QMdnsEngine::AddressTable::current(), table);
+
+    // A refreshed table replaces it, while the old one remains valid
+    QSharedPointer<const QMdnsEngine::AddressTable> refreshed = QMdnsEngine::AddressTable::refresh();
+    QVERIFY(refreshed != table);
+    QCOMPARE(QMdnsEngine::AddressTable::current(), refreshed);
+    const QMdnsEngine::InterfaceFilter filter;
+    QVERIFY(refreshed->usedAddresses(filter) == table->usedAddresses(filter));
+    QCOMPARE(table->interfaces().count(), refreshed->interfaces().count());
+}
+
+void TestAddressTable::testLocalAddresses()
+{
+    QSharedPointer<const QMdnsEngine::AddressTable> table = QMdnsEngine::AddressTable::refresh();
+    for (const QNetworkInterface &networkInterface : qAsConst(interfaces)) {
+        const auto entries = networkInterface.addressEntries();
+        for (const QNetworkAddressEntry &entry : entries) {
+            QVERIFY(table->isLocalAddress(entry.ip()));
+        }
+
+        // The local address for each protocol is one of the interface's own
+        for (auto protocol : {QAbstractSocket::IPv4Protocol, QAbstractSocket::IPv6Protocol}) {
+            const QHostAddress address = table->localAddress(networkInterface.index(), protocol);
+            if (address.isNull()) {
+                continue;
+            }
+            QCOMPARE(address.protocol(), protocol);
+            bool found = false;
+            for (const QNetworkAddressEntry &entry : entries) {
+                found |= entry.ip() == address;
+            }
+            QVERIFY(found);
+        }
+    }
+}
+
+void TestAddressTable::testInterfaceIndex()
+{
+    // Each address, and its neighbour on the same subnet, is found on an
+    // interface with an address on that subnet
+    QSharedPointer<const QMdnsEngine::AddressTable> table = QMdnsEngine::AddressTable::refresh();
+    for (const QNetworkInterface &networkInterface : qAsConst(interfaces)) {
+        const auto entries = networkInterface.addressEntries();
+        for (const QNetworkAddressEntry &entry : entries) {
+            if (entry.prefixLength() < 0) {
+                continue;
+            }
+            const QHostAddress address = entry.ip();
+            QVERIFY(inSubnetOf(address, table->interfaceIndex(address)));
+            if (address.protocol() == QAbstractSocket::IPv4Protocol && entry.prefixLength() < 31) {
+                const QHostAddress neighbour(address.toIPv4Address() ^ 1);
+                QVERIFY(inSubnetOf(neighbour, table->interfaceIndex(neighbour)));
+            }
+        }
+    }
+}
+
+void TestAddressTable::testUnknownAddress()
+{
+    QSharedPointer<const QMdnsEngine::AddressTable> table = QMdnsEngine::AddressTable::current();
+    QCOMPARE(table->interfaceIndex(QHostAddress()), 0);
+    QVERIFY(!table->isLocalAddress(QHostAddress()));
+    QCOMPARE(table->localAddress(-1, QAbstractSocket::IPv4Protocol), QHostAddress());
+
+    // An address reserved for documentation is not normally on any subnet
+    const QHostAddress address("192.0.2.1");
+    const int index = table->interfaceIndex(address);
+    QVERIFY(index == 0 || inSubnetOf(address, index));
+    QVERIFY(!table->isLocalAddress(address));
+}
+
+void TestAddressTable::testMulticastInterfaces()
+{
+    // Multicast is only sent on interfaces that are up, can multicast and
+    // have an address for the protocol
+    QSharedPointer<const QMdnsEngine::AddressTable> table = QMdnsEngine::AddressTable::current();
+    for (auto protocol : {QAbstractSocket::IPv4Protocol, QAbstractSocket::IPv6Protocol}) {
+        const auto indexes = table->multicastInterfaces(protocol);
+        for (int index : indexes) {
+            const QNetworkInterface networkInterface = table->networkInterface(index);
+            QVERIFY(networkInterface.flags() & QNetworkInterface::IsUp);
+            QVERIFY(networkInterface.flags() & QNetworkInterface::CanMulticast);
+            QVERIFY(!table->localAddress(index, protocol).isNull());
+        }
+    }
+}
+
+void TestAddressTable::testUsedAddresses()
+{
+    // The server compares the addresses used with its filter between scans
+    // and only reports a change when they differ
+    const QMdnsEngine::AddressTable table(interfaces);
+    const QMdnsEngine::InterfaceFilter filter;
+    const QMdnsEngine::AddressTable::InterfaceAddresses used = table.usedAddresses(filter);
+    if (used.isEmpty()) {
+        QSKIP("no interfaces can be used for multicast");
+    }
+
+    // Remove one of the interfaces in use, as if it had gone down
+    const int index = used.firstKey();
+    QList<QNetworkInterface> remaining;
+    for (const QNetworkInterface &networkInterface : qAsConst(interfaces)) {
+        if (networkInterface.index() != index) {
+            remaining.append(networkInterface);
+        }
+    }
+    const QMdnsEngine::AddressTable changedTable(remaining);
+    QVERIFY(changedTable.usedAddresses(filter) != used);
+
+    // Once the interface is excluded by the filter, the change is ignored
+    QMdnsEngine::InterfaceFilter excludingFilter;
+    excludingFilter.setDeniedIndexes({index});
+    QVERIFY(!table.usedAddresses(excludingFilter).contains(index));
+    QVERIFY(changedTable.usedAddresses(excludingFilter) == table.usedAddresses(excludingFilter));
+
+    // Addresses of a protocol excluded by the filter are left out too
+    QMdnsEngine::InterfaceFilter ipv4Filter;
+    ipv4Filter.setProtocol(QAbstractSocket::IPv4Protocol);
+    const auto ipv4Used = table.usedAddresses(ipv4Filter);
+    for (const QList<QHostAddress> &addresses : ipv4Used) {
+        for (const QHostAddress &address : addresses) {
+            QCOMPARE(address.protocol(), QAbstractSocket::IPv4Protocol);
+        }
+    }
+}
+
+bool TestAddressTable::inSubnetOf(const QHostAddress &address, int interfaceIndex) const
+{
+    for (const QNetworkInterface &networkInterface : interfaces) {
+        if (networkInterface.index() != interfaceIndex) {
+            continue;
+        }
+        const auto entries = networkInterface.addressEntries();
+        for (const QNetworkAddressEntry &entry : entries) {
+            if (entry.prefixLength() >= 0 && address.isInSubnet(entry.ip(), entry.prefixLength())) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+QTEST_MAIN(TestAddressTable)
+#include "TestAddressTable.moc"
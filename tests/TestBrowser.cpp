@@ -26,6 +26,7 @@
 #include <QTest>
 
 #include <qmdnsengine/browser.h>
+#include <qmdnsengine/cache.h>
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/mdns.h>
 #include <qmdnsengine/message.h>
@@ -55,6 +56,13 @@ private Q_SLOTS:
     void initTestCase();
     void testBrowser();
     void testBrowsePtr();
+    void testQueryBackoff();
+    void testRefresh();
+    void testKnownAnswers();
+
+private:
+
+    int ptrQueries(const TestServer &server) const;
 };
 
 void TestBrowser::initTestCase()
@@ -168,5 +176,108 @@ void TestBrowser::testBrowsePtr()
     QTRY_VERIFY(queryReceived(&server, Type, QMdnsEngine::PTR));
 }
 
+void TestBrowser::testQueryBackoff()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+
+    // The first query is sent right away
+    QCOMPARE(ptrQueries(server), 1);
+
+    // Queries should follow 100, 200, and 400 ms apart; the next one is not
+    // due until 800 ms after that
+    browser.setMinimumQueryInterval(100);
+    server.clearReceivedMessages();
+    QTRY_COMPARE_WITH_TIMEOUT(ptrQueries(server), 3, 5000);
+    QTest::qWait(400);
+    QCOMPARE(ptrQueries(server), 3);
+
+    // A change to the interfaces must restart the queries immediately
+    browser.setMinimumQueryInterval(60 * 1000);
+    server.clearReceivedMessages();
+    emit server.interfacesChanged();
+    QCOMPARE(ptrQueries(server), 1);
+}
+
+void TestBrowser::testRefresh()
+{
+    TestServer server;
+    QMdnsEngine::Cache cache;
+    QMdnsEngine::Browser browser(&server, Type, &cache);
+    browser.setMinimumQueryInterval(60 * 1000);
+
+    // Add two records that are due to be refreshed at about the same time
+    QMdnsEngine::Record record;
+    record.setName(Fqdn);
+    record.setType(QMdnsEngine::SRV);
+    record.setTarget(Target);
+    record.setPort(Port);
+    record.setTtl(1);
+    cache.addRecord(record);
+    record.setName("Other." + Type);
+    cache.addRecord(record);
+    server.clearReceivedMessages();
+
+    // Both records should be refreshed with a single query (TestServer saves
+    // a copy for each protocol)
+    QTRY_VERIFY(queryReceived(&server, Fqdn, QMdnsEngine::SRV));
+    const auto messages = server.receivedMessages();
+    QCOMPARE(messages.count(), 2);
+    for (const QMdnsEngine::Message &message : messages) {
+        QCOMPARE(message.queries().count(), 2);
+    }
+}
+
+void TestBrowser::testKnownAnswers()
+{
+    TestServer server;
+    QMdnsEngine::Cache cache;
+    QMdnsEngine::Browser browser(&server, Type, &cache);
+    browser.setMinimumQueryInterval(60 * 1000);
+
+    // Add one PTR record that will soon be past half of its TTL and one
+    // that will not
+    QMdnsEngine::Record record;
+    record.setName(Type);
+    record.setType(QMdnsEngine::PTR);
+    record.setTarget(Fqdn);
+    record.setTtl(1);
+    cache.addRecord(record);
+    record.setTarget("Other." + Type);
+    record.setTtl(60);
+    cache.addRecord(record);
+    QTest::qWait(600);
+
+    // Only the fresh record is a known answer, with the TTL that remains
+    server.clearReceivedMessages();
+    emit server.interfacesChanged();
+    const auto messages = server.receivedMessages();
+    QVERIFY(!messages.isEmpty());
+    const auto records = messages.at(0).records();
+    QCOMPARE(records.count(), 1);
+    QCOMPARE(records.at(0).target(), "Other." + Type);
+    QCOMPARE(records.at(0).ttl(), 59u);
+}
+
+int TestBrowser::ptrQueries(const TestServer &server) const
+{
+    // TestServer saves a copy of the message for each protocol when it is
+    // sent to all, so only the IPv4 copies are counted
+    int count = 0;
+    const auto messages = server.receivedMessages();
+    for (const QMdnsEngine::Message &message : messages) {
+        if (message.address() != QMdnsEngine::MdnsIpv4Address) {
+            continue;
+        }
+        const auto queries = message.queries();
+        for (const QMdnsEngine::Query &query : queries) {
+            if (query.name() == Type && query.type() == QMdnsEngine::PTR) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
 QTEST_MAIN(TestBrowser)
 #include "TestBrowser.moc"
@@ -29,6 +29,7 @@
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/cache.h>
 #include <qmdnsengine/record.h>
+#include <qmdnsengine/statistics.h>
 
 Q_DECLARE_METATYPE(QMdnsEngine::Record)
 
@@ -49,6 +50,9 @@ private Q_SLOTS:
     void testExpiry();
     void testRemoval();
     void testCacheFlush();
+    void testLookup();
+    void testKnownAnswers();
+    void testStatistics();
 
 private:
 
@@ -123,6 +127,94 @@ void TestCache::testCacheFlush()
     QCOMPARE(records.length(), 1);
 }
 
+void TestCache::testLookup()
+{
+    QMdnsEngine::Cache cache;
+    cache.addRecord(createRecord());
+
+    QMdnsEngine::Record srvRecord;
+    srvRecord.setName(Name);
+    srvRecord.setType(QMdnsEngine::SRV);
+    cache.addRecord(srvRecord);
+
+    QMdnsEngine::Record otherRecord = createRecord();
+    otherRecord.setName("Other");
+    cache.addRecord(otherRecord);
+
+    // Records should only be found for the requested name and type
+    QList<QMdnsEngine::Record> records;
+    QVERIFY(cache.lookupRecords(Name, Type, records));
+    QCOMPARE(records.length(), 1);
+    records.clear();
+    QVERIFY(!cache.lookupRecords(Name, QMdnsEngine::PTR, records));
+    QVERIFY(!cache.lookupRecords("Missing", Type, records));
+
+    // Using ANY for the type should find records of every type
+    QVERIFY(cache.lookupRecords(Name, QMdnsEngine::ANY, records));
+    QCOMPARE(records.length(), 2);
+
+    // Using a null name should find records with every name
+    records.clear();
+    QVERIFY(cache.lookupRecords(QByteArray(), Type, records));
+    QCOMPARE(records.length(), 2);
+    records.clear();
+    QVERIFY(cache.lookupRecords(QByteArray(), QMdnsEngine::ANY, records));
+    QCOMPARE(records.length(), 3);
+}
+
+void TestCache::testKnownAnswers()
+{
+    QMdnsEngine::Cache cache;
+    cache.addRecord(createRecord());
+
+    QMdnsEngine::Record otherRecord = createRecord();
+    otherRecord.setName("Other");
+    otherRecord.setTtl(60);
+    cache.addRecord(otherRecord);
+
+    // Both records are known answers while they are fresh
+    QList<QMdnsEngine::Record> records;
+    QVERIFY(cache.lookupKnownAnswers(Name, Type, records));
+    QVERIFY(cache.lookupKnownAnswers("Other", Type, records));
+    QCOMPARE(records.count(), 2);
+
+    // Once less than half of its TTL remains, the first record is no longer
+    // a known answer; the other one is sent with the TTL that remains
+    QTest::qWait(600);
+    records.clear();
+    QVERIFY(!cache.lookupKnownAnswers(Name, Type, records));
+    QVERIFY(cache.lookupKnownAnswers("Other", Type, records));
+    QCOMPARE(records.count(), 1);
+    QCOMPARE(records.at(0).ttl(), 59u);
+}
+
+void TestCache::testStatistics()
+{
+    QMdnsEngine::Cache cache;
+    cache.addRecord(createRecord());
+    QMdnsEngine::Record record = createRecord();
+    cache.addRecord(record);
+
+    QMdnsEngine::Record lookupRecord;
+    QVERIFY(cache.lookupRecord(Name, Type, lookupRecord));
+    QVERIFY(!cache.lookupRecord(Name, QMdnsEngine::PTR, lookupRecord));
+
+    QMdnsEngine::Statistics statistics = cache.statistics();
+    QCOMPARE(statistics.counter(QMdnsEngine::Statistics::CachedRecords), 2ull);
+    QCOMPARE(statistics.counter(QMdnsEngine::Statistics::CacheLookups), 2ull);
+    QCOMPARE(statistics.counter(QMdnsEngine::Statistics::CacheHits), 1ull);
+    QCOMPARE(statistics.counter(QMdnsEngine::Statistics::CacheMisses), 1ull);
+
+    // Removing one record and letting the other expire must empty the cache
+    record.setTtl(0);
+    cache.addRecord(record);
+    QCOMPARE(cache.statistics().counter(QMdnsEngine::Statistics::CachedRecords), 1ull);
+    QTRY_COMPARE(cache.statistics().counter(QMdnsEngine::Statistics::RecordsExpired), 1ull);
+    statistics = cache.statistics();
+    QCOMPARE(statistics.counter(QMdnsEngine::Statistics::CachedRecords), 0ull);
+    QVERIFY(statistics.counter(QMdnsEngine::Statistics::TriggersFired) > 1);
+}
+
 QMdnsEngine::Record TestCache::createRecord()
 {
     QMdnsEngine::Record record;
@@ -0,0 +1,315 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+#include "common/testserver.h"
+#include "dispatcher_p.h"
+
+const QByteArray Name = "Test.local.";
+const QByteArray OtherName = "Other.local.";
+const QByteArray Type = "_test._tcp.local.";
+const QByteArray Fqdn = "Service." + Type;
+
+class TestDispatcher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testInstance();
+    void testExactMatch();
+    void testSuffixMatch();
+    void testAnyType();
+    void testDirections();
+    void testQueryTrimming();
+    void testMessageFields();
+    void testUnsubscribe();
+    void testListenerDestroyed();
+
+private:
+
+    QMdnsEngine::Dispatcher::Handler collect(QList<QMdnsEngine::Message> &messages) const;
+    QMdnsEngine::Record record(const QByteArray &name, quint16 type) const;
+    QMdnsEngine::Query query(const QByteArray &name, quint16 type) const;
+    QMdnsEngine::Message response(const QList<QMdnsEngine::Record> &records) const;
+};
+
+void TestDispatcher::testInstance()
+{
+    TestServer server;
+    TestServer otherServer;
+
+    // Each server has exactly one dispatcher
+    QMdnsEngine::Dispatcher *dispatcher = QMdnsEngine::Dispatcher::instance(&server);
+    QCOMPARE(QMdnsEngine::Dispatcher::instance(&server), dispatcher);
+    QVERIFY(QMdnsEngine::Dispatcher::instance(&otherServer) != dispatcher);
+}
+
+void TestDispatcher::testExactMatch()
+{
+    TestServer server;
+    QObject listener;
+    QList<QMdnsEngine::Message> messages;
+    QMdnsEngine::Dispatcher *dispatcher = QMdnsEngine::Dispatcher::instance(&server);
+    dispatcher->addListener(&listener, QMdnsEngine::Dispatcher::Responses, collect(messages));
+    dispatcher->subscribe(&listener, Name, QMdnsEngine::A);
+
+    // Only the record with the subscribed name and type is delivered
+    server.deliverMessage(response({
+        record(Name, QMdnsEngine::A),
+        record(Name, QMdnsEngine::AAAA),
+        record(OtherName, QMdnsEngine::A)
+    }));
+    QCOMPARE(messages.count(), 1);
+    QCOMPARE(messages.at(0).records().count(), 1);
+    QCOMPARE(messages.at(0).records().at(0).name(), Name);
+    QCOMPARE(messages.at(0).records().at(0).type(), static_cast<quint16>(QMdnsEngine::A));
+
+    // Messages without a match are not delivered at all
+    server.deliverMessage(response({record(OtherName, QMdnsEngine::A)}));
+    QCOMPARE(messages.count(), 1);
+}
+
+void TestDispatcher::testSuffixMatch()
+{
+    TestServer server;
+    QObject listener;
+    QList<QMdnsEngine::Message> messages;
+    QMdnsEngine::Dispatcher *dispatcher = QMdnsEngine::Dispatcher::instance(&server);
+    dispatcher->addListener(&listener, QMdnsEngine::Dispatcher::Responses, collect(messages));
+    dispatcher->subscribeSuffix(&listener, Type, QMdnsEngine::SRV);
+
+    // Names ending with the suffix match, but the suffix itself does not
+    server.deliverMessage(response({
+        record(Fqdn, QMdnsEngine::SRV),
+        record(Type, QMdnsEngine::SRV),
+        record(Fqdn, QMdnsEngine::TXT),
+        record("Service._other._tcp.local.", QMdnsEngine::SRV)
+    }));
+    QCOMPARE(messages.count(), 1);
+    QCOMPARE(messages.at(0).records().count(), 1);
+    QCOMPARE(messages.at(0).records().at(0).name(), Fqdn);
+}
+
+void TestDispatcher::testAnyType()
+{
+    TestServer server;
+    QObject listener;
+    QList<QMdnsEngine::Message> messages;
+    QMdnsEngine::Dispatcher *dispatcher = QMdnsEngine::Dispatcher::instance(&server);
+    dispatcher->addListener(&listener, QMdnsEngine::Dispatcher::Queries, collect(messages));
+    dispatcher->subscribe(&listener, Name, QMdnsEngine::A);
+
+    // A query for ANY matches a subscription for a specific type
+    QMdnsEngine::Message message;
+    message.addQuery(query(Name, QMdnsEngine::ANY));
+    server.deliverMessage(message);
+    QCOMPARE(messages.count(), 1);
+    QCOMPARE(messages.at(0).queries().count(), 1);
+}
+
+void TestDispatcher::testDirections()
+{
+    TestServer server;
+    QObject queryListener;
+    QObject responseListener;
+    QList<QMdnsEngine::Message> queries;
+    QList<QMdnsEngine::Message> responses;
+    QMdnsEngine::Dispatcher *dispatcher = QMdnsEngine::Dispatcher::instance(&server);
+    dispatcher->addListener(&queryListener, QMdnsEngine::Dispatcher::Queries, collect(queries));
+    dispatcher->subscribe(&queryListener, Name, QMdnsEngine::A);
+    dispatcher->addListener(&responseListener, QMdnsEngine::Dispatcher::Responses, collect(responses));
+    dispatcher->subscribe(&responseListener, Name, QMdnsEngine::A);
+
+    QMdnsEngine::Message message;
+    message.addQuery(query(Name, QMdnsEngine::A));
+    server.deliverMessage(message);
+    server.deliverMessage(response({record(Name, QMdnsEngine::A)}));
+
+    QCOMPARE(queries.count(), 1);
+    QVERIFY(!queries.at(0).isResponse());
+    QCOMPARE(responses.count(), 1);
+    QVERIFY(responses.at(0).isResponse());
+}
+
+void TestDispatcher::testQueryTrimming()
+{
+    TestServer server;
+    QObject listener;
+    QObject knownAnswerListener;
+    QList<QMdnsEngine::Message> messages;
+    QList<QMdnsEngine::Message> knownAnswerMessages;
+    QMdnsEngine::Dispatcher *dispatcher = QMdnsEngine::Dispatcher::instance(&server);
+    dispatcher->addListener(&listener, QMdnsEngine::Dispatcher::Queries, collect(messages));
+    dispatcher->subscribe(&listener, Name, QMdnsEngine::A);
+    dispatcher->addListener(&knownAnswerListener,
+            QMdnsEngine::Dispatcher::Queries | QMdnsEngine::Dispatcher::KnownAnswers,
+            collect(knownAnswerMessages));
+    dispatcher->subscribe(&knownAnswerListener, OtherName, QMdnsEngine::A);
+
+    // The first listener only receives its own question and known answer
+    QMdnsEngine::Message message;
+    message.addQuery(query(Name, QMdnsEngine::A));
+    message.addRecord(record(Name, QMdnsEngine::A));
+    message.addRecord(record(OtherName, QMdnsEngine::A));
+    server.deliverMessage(message);
+    QCOMPARE(messages.count(), 1);
+    QCOMPARE(messages.at(0).queries().count(), 1);
+    QCOMPARE(messages.at(0).queries().at(0).name(), Name);
+    QCOMPARE(messages.at(0).records().count(), 1);
+    QCOMPARE(messages.at(0).records().at(0).name(), Name);
+
+    // Known answers without a matching question only reach listeners that
+    // asked for them
+    QCOMPARE(knownAnswerMessages.count(), 1);
+    QCOMPARE(knownAnswerMessages.at(0).queries().count(), 0);
+    QCOMPARE(knownAnswerMessages.at(0).records().count(), 1);
+    QCOMPARE(knownAnswerMessages.at(0).records().at(0).name(), OtherName);
+}
+
+void TestDispatcher::testMessageFields()
+{
+    TestServer server;
+    QObject listener;
+    QList<QMdnsEngine::Message> messages;
+    QMdnsEngine::Dispatcher *dispatcher = QMdnsEngine::Dispatcher::instance(&server);
+    dispatcher->addListener(&listener, QMdnsEngine::Dispatcher::Queries, collect(messages));
+    dispatcher->subscribe(&listener, Name, QMdnsEngine::A);
+
+    // The trimmed message keeps everything but the questions and records
+    QMdnsEngine::Message message;
+    message.setAddress(QHostAddress("192.168.1.1"));
+    message.setPort(QMdnsEngine::MdnsPort);
+    message.setInterfaceIndex(2);
+    message.setTransactionId(1234);
+    message.setTruncated(true);
+    message.addQuery(query(Name, QMdnsEngine::A));
+    server.deliverMessage(message);
+    QCOMPARE(messages.count(), 1);
+    const QMdnsEngine::Message &trimmed = messages.at(0);
+    QCOMPARE(trimmed.address(), message.address());
+    QCOMPARE(trimmed.port(), message.port());
+    QCOMPARE(trimmed.interfaceIndex(), 2);
+    QCOMPARE(trimmed.transactionId(), static_cast<quint16>(1234));
+    QVERIFY(trimmed.isTruncated());
+    QVERIFY(!trimmed.isResponse());
+}
+
+void TestDispatcher::testUnsubscribe()
+{
+    TestServer server;
+    QObject listener;
+    QList<QMdnsEngine::Message> messages;
+    QMdnsEngine::Dispatcher *dispatcher = QMdnsEngine::Dispatcher::instance(&server);
+    dispatcher->addListener(&listener, QMdnsEngine::Dispatcher::Responses, collect(messages));
+    dispatcher->subscribe(&listener, Name, QMdnsEngine::A);
+    dispatcher->subscribe(&listener, Name, QMdnsEngine::AAAA);
+
+    dispatcher->unsubscribe(&listener, Name, QMdnsEngine::A);
+    server.deliverMessage(response({record(Name, QMdnsEngine::A)}));
+    QCOMPARE(messages.count(), 0);
+    server.deliverMessage(response({record(Name, QMdnsEngine::AAAA)}));
+    QCOMPARE(messages.count(), 1);
+
+    dispatcher->unsubscribeAll(&listener);
+    server.deliverMessage(response({record(Name, QMdnsEngine::AAAA)}));
+    QCOMPARE(messages.count(), 1);
+}
+
+void TestDispatcher::testListenerDestroyed()
+{
+    TestServer server;
+    QList<QMdnsEngine::Message> messages;
+    QMdnsEngine::Dispatcher *dispatcher = QMdnsEngine::Dispatcher::instance(&server);
+    QObject *listener = new QObject;
+    dispatcher->addListener(listener, QMdnsEngine::Dispatcher::Responses, collect(messages));
+    dispatcher->subscribe(listener, Name, QMdnsEngine::A);
+
+    // The listener is removed along with its subscriptions once destroyed
+    delete listener;
+    server.deliverMessage(response({record(Name, QMdnsEngine::A)}));
+    QCOMPARE(messages.count(), 0);
+
+    // A handler may destroy another listener that also matched
+    QObject first;
+    QObject *second = new QObject;
+    QList<QMdnsEngine::Message> secondMessages;
+    dispatcher->addListener(&first, QMdnsEngine::Dispatcher::Responses,
+            [&](const QMdnsEngine::Message &message) {
+        messages.append(message);
+        delete second;
+    });
+    dispatcher->subscribe(&first, Name, QMdnsEngine::A);
+    dispatcher->addListener(second, QMdnsEngine::Dispatcher::Responses, collect(secondMessages));
+    dispatcher->subscribe(second, Name, QMdnsEngine::A);
+    server.deliverMessage(response({record(Name, QMdnsEngine::A)}));
+    QCOMPARE(messages.count(), 1);
+    QCOMPARE(secondMessages.count(), 0);
+}
+
+QMdnsEngine::Dispatcher::Handler TestDispatcher::collect(QList<QMdnsEngine::Message> &messages) const
+{
+    return [&messages](const QMdnsEngine::Message &message) {
+        messages.append(message);
+    };
+}
+
+QMdnsEngine::Record TestDispatcher::record(const QByteArray &name, quint16 type) const
+{
+    QMdnsEngine::Record record;
+    record.setName(name);
+    record.setType(type);
+    return record;
+}
+
+QMdnsEngine::Query TestDispatcher::query(const QByteArray &name, quint16 type) const
+{
+    QMdnsEngine::Query query;
+    query.setName(name);
+    query.setType(type);
+    return query;
+}
+
+QMdnsEngine::Message TestDispatcher::response(const QList<QMdnsEngine::Record> &records) const
+{
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    for (const QMdnsEngine::Record &record : records) {
+        message.addRecord(record);
+    }
+    return message;
+}
+
+QTEST_MAIN(TestDispatcher)
+#include "TestDispatcher.moc"
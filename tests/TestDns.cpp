@@ -22,12 +22,16 @@
  * IN THE SOFTWARE.
  */
 
+#include <utility>
+
 #include <QHostAddress>
 #include <QMap>
 #include <QObject>
 #include <QTest>
 
 #include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
 #include <qmdnsengine/record.h>
 
 #define PARSE_RECORD(r) \
@@ -149,6 +153,15 @@ private Q_SLOTS:
     void testWriteRecordPTR();
     void testWriteRecordSRV();
     void testWriteRecordTXT();
+
+    void testToPacket();
+    void testToPacketModified();
+
+    void testToPackets_data();
+    void testToPackets();
+    void testToPacketsSplitQueries();
+
+    void testMove();
 };
 
 void TestDns::testParseName_data()
@@ -365,5 +378,229 @@ void TestDns::testWriteRecordTXT()
     QCOMPARE(packet, QByteArray(RecordTXT, sizeof(RecordTXT)));
 }
 
+void TestDns::testToPacket()
+{
+    // Create a message whose names share suffixes with each other
+    QMdnsEngine::Query query;
+    query.setName(Name);
+    query.setType(QMdnsEngine::PTR);
+    QMdnsEngine::Record ptrRecord;
+    ptrRecord.setName(Name);
+    ptrRecord.setType(QMdnsEngine::PTR);
+    ptrRecord.setTarget("a." + Name);
+    QMdnsEngine::Record srvRecord;
+    srvRecord.setName("a." + Name);
+    srvRecord.setType(QMdnsEngine::SRV);
+    srvRecord.setPort(Port);
+    srvRecord.setTarget(Target);
+    QMdnsEngine::Record txtRecord;
+    txtRecord.setName("a." + Name);
+    txtRecord.setType(QMdnsEngine::TXT);
+    txtRecord.setAttributes(Attributes);
+    QMdnsEngine::Record aRecord;
+    aRecord.setName(Target);
+    aRecord.setType(QMdnsEngine::A);
+    aRecord.setAddress(Ipv4Address);
+    QMdnsEngine::Message message;
+    message.addQuery(query);
+    message.addRecord(ptrRecord);
+    message.addRecord(srvRecord);
+    message.addRecord(txtRecord);
+    message.addRecord(aRecord);
+
+    QByteArray packet;
+    QMdnsEngine::toPacket(message, packet);
+
+    // Each repeated name must be written as a pointer to its first use
+    QCOMPARE(packet.count(QByteArray("\x04test")), 1);
+    QCOMPARE(packet.count(QByteArray("\x05test2")), 1);
+
+    QMdnsEngine::Message parsedMessage;
+    QVERIFY(QMdnsEngine::fromPacket(packet, parsedMessage));
+    QCOMPARE(parsedMessage.queries().count(), 1);
+    QCOMPARE(parsedMessage.queries().at(0).name(), Name);
+    QCOMPARE(parsedMessage.records().count(), message.records().count());
+    for (int i = 0; i < message.records().count(); ++i) {
+        QVERIFY(parsedMessage.records().at(i) == message.records().at(i));
+    }
+}
+
+void TestDns::testToPacketModified()
+{
+    // The encoding of a record is kept between packets, so changes made to
+    // the record (or to a copy of it) must be reflected in the next packet
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(QMdnsEngine::SRV);
+    record.setPort(Port);
+    record.setTarget(Target);
+    QMdnsEngine::Message message;
+    message.addRecord(record);
+    QByteArray packet;
+    QMdnsEngine::toPacket(message, packet);
+
+    QMdnsEngine::Record modifiedRecord = record;
+    modifiedRecord.setPort(Port + 1);
+    modifiedRecord.setTarget("a." + Target);
+    modifiedRecord.setTtl(1);
+    QMdnsEngine::Message modifiedMessage;
+    modifiedMessage.addRecord(modifiedRecord);
+    QByteArray modifiedPacket;
+    QMdnsEngine::toPacket(modifiedMessage, modifiedPacket);
+
+    QMdnsEngine::Message parsedMessage;
+    QVERIFY(QMdnsEngine::fromPacket(modifiedPacket, parsedMessage));
+    QCOMPARE(parsedMessage.records().count(), 1);
+    QCOMPARE(parsedMessage.records().at(0), modifiedRecord);
+    QCOMPARE(parsedMessage.records().at(0).ttl(), 1u);
+
+    // The original record must still be written as it was
+    QByteArray originalPacket;
+    QMdnsEngine::toPacket(message, originalPacket);
+    QCOMPARE(originalPacket, packet);
+
+    // A copy that only changes the TTL and cache flush bit keeps the
+    // encoding, which must not include either of them
+    QMdnsEngine::Record ttlRecord = record;
+    ttlRecord.setTtl(1);
+    ttlRecord.setFlushCache(true);
+    QMdnsEngine::Message ttlMessage;
+    ttlMessage.addRecord(ttlRecord);
+    QByteArray ttlPacket;
+    QMdnsEngine::toPacket(ttlMessage, ttlPacket);
+    QMdnsEngine::Message parsedTtlMessage;
+    QVERIFY(QMdnsEngine::fromPacket(ttlPacket, parsedTtlMessage));
+    QCOMPARE(parsedTtlMessage.records().count(), 1);
+    QCOMPARE(parsedTtlMessage.records().at(0), ttlRecord);
+    QCOMPARE(parsedTtlMessage.records().at(0).ttl(), 1u);
+    QVERIFY(parsedTtlMessage.records().at(0).flushCache());
+}
+
+void TestDns::testToPackets_data()
+{
+    QTest::addColumn<bool>("isResponse");
+
+    QTest::newRow("query") << false;
+    QTest::newRow("response") << true;
+}
+
+void TestDns::testToPackets()
+{
+    QFETCH(bool, isResponse);
+
+    // Create a message with far more records than fit in a single packet
+    const int MaxSize = 512;
+    const int RecordCount = 100;
+    QMdnsEngine::Query query;
+    query.setName(Name);
+    query.setType(QMdnsEngine::PTR);
+    QMdnsEngine::Message message;
+    message.setResponse(isResponse);
+    message.addQuery(query);
+    for (int i = 0; i < RecordCount; ++i) {
+        QMdnsEngine::Record record;
+        record.setName(Name);
+        record.setType(QMdnsEngine::PTR);
+        record.setTarget("service" + QByteArray::number(i) + "." + Name);
+        message.addRecord(record);
+    }
+
+    const auto packets = QMdnsEngine::toPackets(message, MaxSize);
+    QVERIFY(packets.count() > 1);
+
+    // Each packet must fit and be valid; only the first contains the query
+    // and all but the last set the TC bit if the message is a query
+    int records = 0;
+    for (int i = 0; i < packets.count(); ++i) {
+        QVERIFY(packets.at(i).length() <= MaxSize);
+        QMdnsEngine::Message packetMessage;
+        QVERIFY(QMdnsEngine::fromPacket(packets.at(i), packetMessage));
+        QCOMPARE(packetMessage.isResponse(), isResponse);
+        QCOMPARE(packetMessage.queries().count(), i == 0 ? 1 : 0);
+        QCOMPARE(packetMessage.isTruncated(), !isResponse && i < packets.count() - 1);
+        records += packetMessage.records().count();
+    }
+    QCOMPARE(records, RecordCount);
+}
+
+void TestDns::testToPacketsSplitQueries()
+{
+    // Create a query with more questions than fit in a single packet,
+    // followed by a known answer
+    const int MaxSize = 512;
+    const int QueryCount = 50;
+    QMdnsEngine::Message message;
+    for (int i = 0; i < QueryCount; ++i) {
+        QMdnsEngine::Query query;
+        query.setName("service" + QByteArray::number(i) + "." + Name);
+        query.setType(QMdnsEngine::SRV);
+        message.addQuery(query);
+    }
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(QMdnsEngine::PTR);
+    record.setTarget("service0." + Name);
+    message.addRecord(record);
+
+    const auto packets = QMdnsEngine::toPackets(message, MaxSize);
+    QVERIFY(packets.count() > 1);
+
+    // The known answer comes last, so every packet before it must set the
+    // TC bit even though it was split among the questions
+    int queries = 0;
+    for (int i = 0; i < packets.count(); ++i) {
+        QMdnsEngine::Message packetMessage;
+        QVERIFY(QMdnsEngine::fromPacket(packets.at(i), packetMessage));
+        QCOMPARE(packetMessage.isTruncated(), i < packets.count() - 1);
+        queries += packetMessage.queries().count();
+    }
+    QCOMPARE(queries, QueryCount);
+
+    // Without known answers, there is nothing to wait for
+    QMdnsEngine::Message queriesOnly;
+    const auto allQueries = message.queries();
+    for (const QMdnsEngine::Query &query : allQueries) {
+        queriesOnly.addQuery(query);
+    }
+    const auto queryPackets = QMdnsEngine::toPackets(queriesOnly, MaxSize);
+    QVERIFY(queryPackets.count() > 1);
+    for (const QByteArray &packet : queryPackets) {
+        QMdnsEngine::Message packetMessage;
+        QVERIFY(QMdnsEngine::fromPacket(packet, packetMessage));
+        QVERIFY(!packetMessage.isTruncated());
+    }
+}
+
+void TestDns::testMove()
+{
+    // Values that have been moved from are left empty and remain usable
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(QMdnsEngine::SRV);
+    QMdnsEngine::Record movedRecord(std::move(record));
+    QCOMPARE(movedRecord.name(), Name);
+    QVERIFY(record == QMdnsEngine::Record());
+    record.setName(Target);
+    QCOMPARE(record.name(), Target);
+    QCOMPARE(QMdnsEngine::Record().name(), QByteArray());
+
+    QMdnsEngine::Query query;
+    query.setName(Name);
+    QMdnsEngine::Query movedQuery(std::move(query));
+    QCOMPARE(movedQuery.name(), Name);
+    QCOMPARE(query.name(), QByteArray());
+    query.setType(QMdnsEngine::A);
+    QCOMPARE(query.type(), static_cast<quint16>(QMdnsEngine::A));
+
+    QMdnsEngine::Message message;
+    message.addRecord(movedRecord);
+    QMdnsEngine::Message movedMessage(std::move(message));
+    QCOMPARE(movedMessage.records().count(), 1);
+    QCOMPARE(message.records().count(), 0);
+    message.addQuery(movedQuery);
+    QCOMPARE(message.queries().count(), 1);
+    QCOMPARE(QMdnsEngine::Message().queries().count(), 0);
+}
+
 QTEST_MAIN(TestDns)
 #include "TestDns.moc"
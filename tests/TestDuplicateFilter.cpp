@@ -0,0 +1,135 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/mdns.h>
+
+#include "duplicatefilter_p.h"
+
+const QByteArray Packet("packet");
+const QByteArray OtherPacket("other packet");
+const QHostAddress Ipv4Address("192.168.1.1");
+const QHostAddress OtherIpv4Address("192.168.1.2");
+const QHostAddress Ipv6Address("fe80::1");
+const int Window = 400;
+
+class TestDuplicateFilter : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testDuplicate();
+    void testSource();
+    void testIgnoreSource();
+    void testWindow();
+    void testCapacity();
+    void testClear();
+    void testOwnPackets();
+};
+
+void TestDuplicateFilter::testDuplicate()
+{
+    QMdnsEngine::DuplicateFilter filter;
+    QVERIFY(!filter.isDuplicate(Packet, Ipv4Address, QMdnsEngine::MdnsPort, false, Window));
+    QVERIFY(filter.isDuplicate(Packet, Ipv4Address, QMdnsEngine::MdnsPort, false, Window));
+    QVERIFY(!filter.isDuplicate(OtherPacket, Ipv4Address, QMdnsEngine::MdnsPort, false, Window));
+}
+
+void TestDuplicateFilter::testSource()
+{
+    // A different address or port makes a different datagram
+    QMdnsEngine::DuplicateFilter filter;
+    QVERIFY(!filter.isDuplicate(Packet, Ipv4Address, QMdnsEngine::MdnsPort, false, Window));
+    QVERIFY(!filter.isDuplicate(Packet, OtherIpv4Address, QMdnsEngine::MdnsPort, false, Window));
+    QVERIFY(!filter.isDuplicate(Packet, Ipv4Address, 1234, false, Window));
+    QVERIFY(!filter.isDuplicate(Packet, Ipv6Address, QMdnsEngine::MdnsPort, false, Window));
+    QVERIFY(filter.isDuplicate(Packet, Ipv6Address, QMdnsEngine::MdnsPort, false, Window));
+}
+
+void TestDuplicateFilter::testIgnoreSource()
+{
+    // The same payload from IPv4 and IPv6 is a duplicate when the source is
+    // ignored
+    QMdnsEngine::DuplicateFilter filter;
+    QVERIFY(!filter.isDuplicate(Packet, Ipv4Address, QMdnsEngine::MdnsPort, true, Window));
+    QVERIFY(filter.isDuplicate(Packet, Ipv6Address, QMdnsEngine::MdnsPort, true, Window));
+    QVERIFY(filter.isDuplicate(Packet, OtherIpv4Address, 1234, true, Window));
+}
+
+void TestDuplicateFilter::testWindow()
+{
+    QMdnsEngine::DuplicateFilter filter;
+    QVERIFY(!filter.isDuplicate(Packet, Ipv4Address, QMdnsEngine::MdnsPort, false, Window));
+
+    // Copies do not extend the window, which runs from the first copy
+    QTest::qWait(Window / 2);
+    QVERIFY(filter.isDuplicate(Packet, Ipv4Address, QMdnsEngine::MdnsPort, false, Window));
+    QTest::qWait(Window / 2 + 50);
+    QVERIFY(!filter.isDuplicate(Packet, Ipv4Address, QMdnsEngine::MdnsPort, false, Window));
+    QVERIFY(filter.isDuplicate(Packet, Ipv4Address, QMdnsEngine::MdnsPort, false, Window));
+}
+
+void TestDuplicateFilter::testCapacity()
+{
+    // Once the filter is full, the oldest datagram is forgotten first
+    QMdnsEngine::DuplicateFilter filter;
+    QVERIFY(!filter.isDuplicate(Packet, Ipv4Address, QMdnsEngine::MdnsPort, false, 60 * 1000));
+    for (int i = 0; i < 2000; ++i) {
+        filter.isDuplicate(QByteArray::number(i), Ipv4Address, QMdnsEngine::MdnsPort, false, 60 * 1000);
+    }
+    QVERIFY(!filter.isDuplicate(Packet, Ipv4Address, QMdnsEngine::MdnsPort, false, 60 * 1000));
+    QVERIFY(filter.isDuplicate(QByteArray::number(1999), Ipv4Address, QMdnsEngine::MdnsPort, false, 60 * 1000));
+}
+
+void TestDuplicateFilter::testClear()
+{
+    QMdnsEngine::DuplicateFilter filter;
+    QVERIFY(!filter.isDuplicate(Packet, Ipv4Address, QMdnsEngine::MdnsPort, false, Window));
+    filter.clear();
+    QVERIFY(!filter.isDuplicate(Packet, Ipv4Address, QMdnsEngine::MdnsPort, false, Window));
+}
+
+void TestDuplicateFilter::testOwnPackets()
+{
+    QMdnsEngine::DuplicateFilter filter;
+    filter.insert(Packet.constData(), Packet.length(), Window);
+    QVERIFY(filter.contains(Packet, Window));
+    QVERIFY(!filter.contains(OtherPacket, Window));
+
+    // Sending the packet again renews it, unlike a received copy
+    QTest::qWait(Window / 2);
+    filter.insert(Packet.constData(), Packet.length(), Window);
+    QTest::qWait(Window * 3 / 4);
+    QVERIFY(filter.contains(Packet, Window));
+    QTest::qWait(Window / 2);
+    QVERIFY(!filter.contains(Packet, Window));
+}
+
+QTEST_MAIN(TestDuplicateFilter)
+#include "TestDuplicateFilter.moc"
@@ -0,0 +1,155 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <utility>
+
+#include <QNetworkInterface>
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/interfacefilter.h>
+
+class TestInterfaceFilter : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void initTestCase();
+    void testDefault();
+    void testNames_data();
+    void testNames();
+    void testIndexes();
+    void testPredicate();
+    void testProtocol();
+    void testMove();
+
+private:
+
+    QNetworkInterface networkInterface;
+};
+
+void TestInterfaceFilter::initTestCase()
+{
+    const auto interfaces = QNetworkInterface::allInterfaces();
+    if (interfaces.isEmpty()) {
+        QSKIP("no network interfaces");
+    }
+    networkInterface = interfaces.first();
+}
+
+void TestInterfaceFilter::testDefault()
+{
+    QMdnsEngine::InterfaceFilter filter;
+    QVERIFY(filter.acceptsInterface(networkInterface));
+    QVERIFY(filter.acceptsProtocol(QAbstractSocket::IPv4Protocol));
+    QVERIFY(filter.acceptsProtocol(QAbstractSocket::IPv6Protocol));
+}
+
+void TestInterfaceFilter::testNames_data()
+{
+    const QString name = networkInterface.name();
+
+    QTest::addColumn<QStringList>("allowedNames");
+    QTest::addColumn<QStringList>("deniedNames");
+    QTest::addColumn<bool>("accepted");
+
+    QTest::newRow("allowed exact") << QStringList{name} << QStringList() << true;
+    QTest::newRow("allowed prefix") << QStringList{name.left(1) + "*"} << QStringList() << true;
+    QTest::newRow("allowed single") << QStringList{"?" + name.mid(1)} << QStringList() << true;
+    QTest::newRow("allowed star") << QStringList{"*"} << QStringList() << true;
+    QTest::newRow("allowed other") << QStringList{name + "?"} << QStringList() << false;
+    QTest::newRow("denied exact") << QStringList() << QStringList{name} << false;
+    QTest::newRow("denied suffix") << QStringList() << QStringList{"*" + name.right(1)} << false;
+    QTest::newRow("denied other") << QStringList() << QStringList{name + "*?"} << true;
+    QTest::newRow("denied wins") << QStringList{"*"} << QStringList{name} << false;
+}
+
+void TestInterfaceFilter::testNames()
+{
+    QFETCH(QStringList, allowedNames);
+    QFETCH(QStringList, deniedNames);
+    QFETCH(bool, accepted);
+
+    QMdnsEngine::InterfaceFilter filter;
+    filter.setAllowedNames(allowedNames);
+    filter.setDeniedNames(deniedNames);
+    QCOMPARE(filter.acceptsInterface(networkInterface), accepted);
+}
+
+void TestInterfaceFilter::testIndexes()
+{
+    QMdnsEngine::InterfaceFilter filter;
+    filter.setAllowedIndexes({networkInterface.index() + 1});
+    QVERIFY(!filter.acceptsInterface(networkInterface));
+
+    // Either an allowed name or an allowed index is enough
+    filter.setAllowedNames({networkInterface.name()});
+    QVERIFY(filter.acceptsInterface(networkInterface));
+    filter.setAllowedNames(QStringList());
+    filter.setAllowedIndexes({networkInterface.index()});
+    QVERIFY(filter.acceptsInterface(networkInterface));
+
+    filter.setDeniedIndexes({networkInterface.index()});
+    QVERIFY(!filter.acceptsInterface(networkInterface));
+}
+
+void TestInterfaceFilter::testPredicate()
+{
+    QMdnsEngine::InterfaceFilter filter;
+    filter.setPredicate([](const QNetworkInterface &) {
+        return false;
+    });
+    QVERIFY(!filter.acceptsInterface(networkInterface));
+
+    // Copies are independent of each other
+    QMdnsEngine::InterfaceFilter copy = filter;
+    copy.setPredicate(QMdnsEngine::InterfaceFilter::Predicate());
+    QVERIFY(copy.acceptsInterface(networkInterface));
+    QVERIFY(!filter.acceptsInterface(networkInterface));
+}
+
+void TestInterfaceFilter::testProtocol()
+{
+    QMdnsEngine::InterfaceFilter filter;
+    filter.setProtocol(QAbstractSocket::IPv4Protocol);
+    QVERIFY(filter.acceptsProtocol(QAbstractSocket::IPv4Protocol));
+    QVERIFY(!filter.acceptsProtocol(QAbstractSocket::IPv6Protocol));
+}
+
+void TestInterfaceFilter::testMove()
+{
+    QMdnsEngine::InterfaceFilter filter;
+    filter.setDeniedIndexes({networkInterface.index()});
+    QMdnsEngine::InterfaceFilter moved(std::move(filter));
+    QVERIFY(!moved.acceptsInterface(networkInterface));
+
+    // The moved-from filter accepts everything and can still be changed
+    QVERIFY(filter.acceptsInterface(networkInterface));
+    filter.setProtocol(QAbstractSocket::IPv6Protocol);
+    QVERIFY(!filter.acceptsProtocol(QAbstractSocket::IPv4Protocol));
+}
+
+QTEST_MAIN(TestInterfaceFilter)
+#include "TestInterfaceFilter.moc"
@@ -0,0 +1,168 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QCoreApplication>
+#include <QHostAddress>
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/server.h>
+#include <qmdnsengine/statistics.h>
+
+Q_DECLARE_METATYPE(QMdnsEngine::Message)
+
+const int Timeout = 2000;
+
+class TestLoopback : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    TestLoopback() : mLoopback(false) {}
+
+private Q_SLOTS:
+
+    void initTestCase();
+    void testInternal();
+    void testDelivered();
+    void testFiltered();
+    void testThreaded();
+
+private:
+
+    QMdnsEngine::Message query() const;
+    int queriesReceived(const QSignalSpy &spy) const;
+
+    QByteArray mName;
+    bool mLoopback;
+};
+
+void TestLoopback::initTestCase()
+{
+    qRegisterMetaType<QMdnsEngine::Message>("Message");
+
+    // The name is unique to this process so that queries sent by other
+    // processes are never mistaken for ours
+    mName = "qmdnsengine-test-" + QByteArray::number(QCoreApplication::applicationPid()) + ".local.";
+}
+
+void TestLoopback::testInternal()
+{
+    QMdnsEngine::Server server;
+    QVERIFY(!server.ownMessagesDelivered());
+    QSignalSpy messageReceivedSpy(&server, SIGNAL(messageReceived(Message)));
+
+    // By default, the query is handed to the listeners of the server
+    // directly, which does not depend on the network
+    server.sendMessageToAll(query());
+    QCOMPARE(queriesReceived(messageReceivedSpy), 0);
+    QTRY_COMPARE_WITH_TIMEOUT(queriesReceived(messageReceivedSpy), 1, Timeout);
+    const auto message = messageReceivedSpy.first().at(0).value<QMdnsEngine::Message>();
+    QCOMPARE(message.address(), QHostAddress(QHostAddress::LocalHost));
+    QCOMPARE(message.port(), QMdnsEngine::MdnsPort);
+}
+
+void TestLoopback::testDelivered()
+{
+    QMdnsEngine::Server server;
+    server.setOwnMessagesDelivered(true);
+    QSignalSpy messageReceivedSpy(&server, SIGNAL(messageReceived(Message)));
+
+    // Once delivery is enabled, the query comes back through multicast
+    // loopback - which depends on the host having a multicast route
+    server.sendMessageToAll(query());
+    QTest::qWait(100);
+    if (!server.statistics().counter(QMdnsEngine::Statistics::PacketsSent)) {
+        QSKIP("multicast is not available");
+    }
+    QTRY_VERIFY_WITH_TIMEOUT(queriesReceived(messageReceivedSpy) > 0, Timeout);
+    mLoopback = true;
+}
+
+void TestLoopback::testFiltered()
+{
+    if (!mLoopback) {
+        QSKIP("multicast loopback is not available");
+    }
+
+    QMdnsEngine::Server server;
+    QSignalSpy messageReceivedSpy(&server, SIGNAL(messageReceived(Message)));
+
+    // The looped-back packets must be recognised and dropped, leaving only
+    // the copy handed over directly
+    server.sendMessageToAll(query());
+    QTRY_VERIFY_WITH_TIMEOUT(server.statistics().counter(QMdnsEngine::Statistics::OwnPacketsDropped) > 0,
+            Timeout);
+    QTest::qWait(200);
+    QCOMPARE(queriesReceived(messageReceivedSpy), 1);
+}
+
+void TestLoopback::testThreaded()
+{
+    if (!mLoopback) {
+        QSKIP("multicast loopback is not available");
+    }
+
+    // Messages received in the I/O thread are delivered in this one
+    QMdnsEngine::Server server;
+    server.setIoThreadEnabled(true);
+    server.setOwnMessagesDelivered(true);
+    QSignalSpy messageReceivedSpy(&server, SIGNAL(messageReceived(Message)));
+    server.sendMessageToAll(query());
+    QTRY_VERIFY_WITH_TIMEOUT(queriesReceived(messageReceivedSpy) > 0, Timeout);
+}
+
+QMdnsEngine::Message TestLoopback::query() const
+{
+    QMdnsEngine::Query query;
+    query.setName(mName);
+    query.setType(QMdnsEngine::A);
+    QMdnsEngine::Message message;
+    message.addQuery(query);
+    return message;
+}
+
+int TestLoopback::queriesReceived(const QSignalSpy &spy) const
+{
+    int count = 0;
+    for (const QList<QVariant> &arguments : spy) {
+        const auto message = arguments.at(0).value<QMdnsEngine::Message>();
+        const auto queries = message.queries();
+        for (const QMdnsEngine::Query &query : queries) {
+            if (query.name() == mName) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+QTEST_MAIN(TestLoopback)
+#include "TestLoopback.moc"
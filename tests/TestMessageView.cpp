@@ -0,0 +1,230 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QHostAddress>
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/messageview.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+const quint16 TransactionId = 1234;
+const QByteArray Name("test._http._tcp.local.");
+const QByteArray Suffix("_http._tcp.local.");
+const QByteArray Target("host.local.");
+const QHostAddress Address("127.0.0.1");
+const quint16 Port = 80;
+
+class TestMessageView : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void initTestCase();
+
+    void testParse();
+    void testRecords();
+    void testToMessage();
+    void testCorrupt();
+    void testShortData();
+    void testLifetime();
+
+private:
+
+    QByteArray packet;
+};
+
+void TestMessageView::initTestCase()
+{
+    QMdnsEngine::Query query;
+    query.setName(Suffix);
+    query.setType(QMdnsEngine::PTR);
+
+    QMdnsEngine::Record ptrRecord;
+    ptrRecord.setName(Suffix);
+    ptrRecord.setType(QMdnsEngine::PTR);
+    ptrRecord.setTtl(3600);
+    ptrRecord.setTarget(Name);
+
+    QMdnsEngine::Record srvRecord;
+    srvRecord.setName(Name);
+    srvRecord.setType(QMdnsEngine::SRV);
+    srvRecord.setFlushCache(true);
+    srvRecord.setTtl(120);
+    srvRecord.setTarget(Target);
+    srvRecord.setPort(Port);
+
+    QMdnsEngine::Record txtRecord;
+    txtRecord.setName(Name);
+    txtRecord.setType(QMdnsEngine::TXT);
+    txtRecord.addAttribute("a", "b");
+
+    QMdnsEngine::Record aRecord;
+    aRecord.setName(Target);
+    aRecord.setType(QMdnsEngine::A);
+    aRecord.setAddress(Address);
+
+    QMdnsEngine::Message message;
+    message.setTransactionId(TransactionId);
+    message.setResponse(true);
+    message.addQuery(query);
+    message.addRecord(ptrRecord);
+    message.addRecord(srvRecord);
+    message.addRecord(txtRecord);
+    message.addRecord(aRecord);
+    QMdnsEngine::toPacket(message, packet);
+}
+
+void TestMessageView::testParse()
+{
+    QMdnsEngine::MessageView view;
+    QVERIFY(view.parse(packet));
+    QCOMPARE(view.transactionId(), TransactionId);
+    QVERIFY(view.isResponse());
+    QVERIFY(!view.isTruncated());
+    QCOMPARE(view.queryCount(), 1);
+    QCOMPARE(view.recordCount(), 4);
+
+    QMdnsEngine::QueryView query = view.query(0);
+    QCOMPARE(query.type(), static_cast<quint16>(QMdnsEngine::PTR));
+    QVERIFY(query.nameEquals(Suffix));
+    QVERIFY(!query.nameEquals(Name));
+    QVERIFY(!query.nameEquals("_tcp.local."));
+    QCOMPARE(query.name(), Suffix);
+}
+
+void TestMessageView::testRecords()
+{
+    QMdnsEngine::MessageView view;
+    QVERIFY(view.parse(packet));
+
+    // The SRV and TXT names are compressed against the PTR target
+    QMdnsEngine::RecordView srvRecord = view.record(1);
+    QCOMPARE(srvRecord.type(), static_cast<quint16>(QMdnsEngine::SRV));
+    QVERIFY(srvRecord.nameEquals(Name));
+    QVERIFY(srvRecord.nameEndsWith(Suffix));
+    QVERIFY(srvRecord.nameEndsWith(Name));
+    QVERIFY(!srvRecord.nameEndsWith("_udp.local."));
+    QVERIFY(!srvRecord.nameEndsWith("x" + Name));
+    QVERIFY(srvRecord.flushCache());
+    QCOMPARE(srvRecord.ttl(), static_cast<quint32>(120));
+    QCOMPARE(srvRecord.target(), Target);
+    QCOMPARE(srvRecord.port(), Port);
+
+    QMdnsEngine::RecordView txtRecord = view.record(2);
+    QCOMPARE(txtRecord.attributes().value("a"), QByteArray("b"));
+
+    QMdnsEngine::RecordView aRecord = view.record(3);
+    QVERIFY(aRecord.nameEquals(Target));
+    QCOMPARE(aRecord.address(), Address);
+}
+
+void TestMessageView::testToMessage()
+{
+    QMdnsEngine::Message message;
+    QVERIFY(QMdnsEngine::fromPacket(packet, message));
+
+    QMdnsEngine::MessageView view;
+    QVERIFY(view.parse(packet));
+    QMdnsEngine::Message viewMessage;
+    QVERIFY(view.toMessage(viewMessage));
+
+    QCOMPARE(viewMessage.transactionId(), message.transactionId());
+    QCOMPARE(viewMessage.isResponse(), message.isResponse());
+    QCOMPARE(viewMessage.queries().count(), message.queries().count());
+    QCOMPARE(viewMessage.records().count(), message.records().count());
+    for (int i = 0; i < message.records().count(); ++i) {
+        QVERIFY(viewMessage.records().at(i) == message.records().at(i));
+    }
+}
+
+void TestMessageView::testCorrupt()
+{
+    QMdnsEngine::MessageView view;
+    QVERIFY(!view.parse(packet.left(packet.length() - 1)));
+    QVERIFY(!view.parse(QByteArray(4, '\0')));
+    QCOMPARE(view.recordCount(), 0);
+}
+
+void TestMessageView::testShortData()
+{
+    // An SRV record whose data only holds the priority, followed by an A
+    // record whose bytes must not be read as the rest of the SRV record
+    const char data[] = {
+        '\x00', '\x00', '\x84', '\x00', '\x00', '\x00', '\x00', '\x02', '\x00', '\x00', '\x00', '\x00',
+        '\x01', 'a', '\x05', 'l', 'o', 'c', 'a', 'l', '\x00',
+        '\x00', '\x21', '\x00', '\x01', '\x00', '\x00', '\x00', '\x78', '\x00', '\x02',
+        '\x00', '\x01',
+        '\xc0', '\x0c',
+        '\x00', '\x01', '\x00', '\x01', '\x00', '\x00', '\x00', '\x78', '\x00', '\x04',
+        '\x7f', '\x00', '\x00', '\x01'
+    };
+    QMdnsEngine::MessageView view;
+    QVERIFY(view.parse(QByteArray(data, sizeof(data))));
+    QCOMPARE(view.recordCount(), 2);
+
+    QMdnsEngine::RecordView srvRecord = view.record(0);
+    QCOMPARE(srvRecord.type(), static_cast<quint16>(QMdnsEngine::SRV));
+    QCOMPARE(srvRecord.priority(), static_cast<quint16>(1));
+    QCOMPARE(srvRecord.weight(), static_cast<quint16>(0));
+    QCOMPARE(srvRecord.port(), static_cast<quint16>(0));
+    QCOMPARE(srvRecord.target(), QByteArray());
+
+    QMdnsEngine::RecordView aRecord = view.record(1);
+    QVERIFY(aRecord.nameEquals("a.local."));
+    QCOMPARE(aRecord.address(), QHostAddress("127.0.0.1"));
+}
+
+void TestMessageView::testLifetime()
+{
+    // Query and record views keep the index alive once the view is gone
+    QMdnsEngine::MessageView *view = new QMdnsEngine::MessageView;
+    QVERIFY(view->parse(packet));
+    QMdnsEngine::RecordView srvRecord = view->record(1);
+    QMdnsEngine::MessageView copy = *view;
+    delete view;
+    QVERIFY(srvRecord.nameEquals(Name));
+    QCOMPARE(srvRecord.port(), Port);
+
+    // Parsing another packet leaves the earlier views and copies untouched
+    QMdnsEngine::Query otherQuery;
+    otherQuery.setName(Target);
+    otherQuery.setType(QMdnsEngine::A);
+    QMdnsEngine::Message otherMessage;
+    otherMessage.addQuery(otherQuery);
+    QByteArray otherPacket;
+    QMdnsEngine::toPacket(otherMessage, otherPacket);
+    QVERIFY(copy.parse(otherPacket));
+    QCOMPARE(copy.recordCount(), 0);
+    QVERIFY(copy.query(0).nameEquals(Target));
+    QVERIFY(srvRecord.nameEquals(Name));
+    QCOMPARE(srvRecord.target(), Target);
+}
+
+QTEST_MAIN(TestMessageView)
+#include "TestMessageView.moc"
@@ -22,11 +22,16 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+
 #include <QTest>
 
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/hostname.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
 #include <qmdnsengine/provider.h>
+#include <qmdnsengine/query.h>
 #include <qmdnsengine/record.h>
 #include <qmdnsengine/service.h>
 
@@ -35,6 +40,8 @@
 const QByteArray Name = "Test";
 const QByteArray Type = "_test._tcp.local.";
 const QByteArray Fqdn = Name + "." + Type;
+const QByteArray Name2 = "Test2";
+const QByteArray Fqdn2 = Name2 + "." + Type;
 const quint16 Port = 1234;
 const QByteArray Key = "key";
 const QByteArray Value = "value";
@@ -46,6 +53,14 @@ class TestProvider : public QObject
 private Q_SLOTS:
 
     void testProvider();
+    void testAggregateReply();
+    void testKnownAnswers();
+    void testInterfaceReply();
+    void testInterfacesChanged();
+
+private:
+
+    QList<QByteArray> ptrTargets(const QMdnsEngine::Message &message) const;
 };
 
 void TestProvider::testProvider()
@@ -73,5 +88,221 @@ void TestProvider::testProvider()
     QCOMPARE(record.attributes(), service.attributes());
 }
 
+void TestProvider::testAggregateReply()
+{
+    TestServer server;
+    QMdnsEngine::Hostname hostname(&server);
+    QMdnsEngine::Provider provider(&server, &hostname);
+    QMdnsEngine::Provider provider2(&server, &hostname);
+
+    // Provide two services of the same type
+    QMdnsEngine::Service service;
+    service.setName(Name);
+    service.setType(Type);
+    service.setPort(Port);
+    provider.update(service);
+    service.setName(Name2);
+    provider2.update(service);
+
+    // Wait for both services to be announced
+    QMdnsEngine::Record record;
+    QTRY_VERIFY(server.cache()->lookupRecord(Fqdn, QMdnsEngine::SRV, record));
+    QTRY_VERIFY(server.cache()->lookupRecord(Fqdn2, QMdnsEngine::SRV, record));
+    server.clearReceivedMessages();
+
+    // Query for the service types and the services of the type
+    QMdnsEngine::Query query;
+    query.setName(QMdnsEngine::MdnsBrowseType);
+    query.setType(QMdnsEngine::PTR);
+    QMdnsEngine::Message message;
+    message.addQuery(query);
+    query.setName(Type);
+    message.addQuery(query);
+    message.setAddress(QMdnsEngine::MdnsIpv4Address);
+    message.setPort(QMdnsEngine::MdnsPort);
+    server.deliverMessage(message);
+
+    // A single (delayed) reply should contain the shared browse PTR record
+    // once and the PTR, SRV and TXT records for both services
+    QTRY_COMPARE(server.receivedMessages().count(), 1);
+    int browsePtrCount = 0;
+    int ptrCount = 0;
+    int srvCount = 0;
+    int txtCount = 0;
+    const auto records = server.receivedMessages().at(0).records();
+    for (const QMdnsEngine::Record &replyRecord : records) {
+        switch (replyRecord.type()) {
+        case QMdnsEngine::PTR:
+            ++(replyRecord.name() == QMdnsEngine::MdnsBrowseType ? browsePtrCount : ptrCount);
+            break;
+        case QMdnsEngine::SRV:
+            ++srvCount;
+            break;
+        case QMdnsEngine::TXT:
+            ++txtCount;
+            break;
+        }
+    }
+    QCOMPARE(browsePtrCount, 1);
+    QCOMPARE(ptrCount, 2);
+    QCOMPARE(srvCount, 2);
+    QCOMPARE(txtCount, 2);
+
+    // Repeating the query immediately must not multicast the records again
+    server.deliverMessage(message);
+    QTest::qWait(200);
+    QCOMPARE(server.receivedMessages().count(), 1);
+}
+
+void TestProvider::testKnownAnswers()
+{
+    TestServer server;
+    QMdnsEngine::Hostname hostname(&server);
+    QMdnsEngine::Provider provider(&server, &hostname);
+    QMdnsEngine::Provider provider2(&server, &hostname);
+
+    QMdnsEngine::Service service;
+    service.setName(Name);
+    service.setType(Type);
+    service.setPort(Port);
+    provider.update(service);
+    service.setName(Name2);
+    provider2.update(service);
+
+    QMdnsEngine::Record record;
+    QTRY_VERIFY(server.cache()->lookupRecord(Fqdn, QMdnsEngine::SRV, record));
+    QTRY_VERIFY(server.cache()->lookupRecord(Fqdn2, QMdnsEngine::SRV, record));
+    server.clearReceivedMessages();
+
+    QMdnsEngine::Query query;
+    query.setName(Type);
+    query.setType(QMdnsEngine::PTR);
+    QMdnsEngine::Record knownRecord;
+    knownRecord.setName(Type);
+    knownRecord.setType(QMdnsEngine::PTR);
+    knownRecord.setTarget(Fqdn);
+    QMdnsEngine::Record staleRecord = knownRecord;
+    staleRecord.setTarget(Fqdn2);
+    staleRecord.setTtl(knownRecord.ttl() / 2 - 1);
+
+    // A known answer only suppresses the answer if its TTL is at least half
+    // of the true TTL
+    QMdnsEngine::Message message;
+    message.setAddress(QMdnsEngine::MdnsIpv4Address);
+    message.setPort(QMdnsEngine::MdnsPort);
+    message.addQuery(query);
+    message.addRecord(knownRecord);
+    message.addRecord(staleRecord);
+    server.deliverMessage(message);
+    QTRY_COMPARE(server.receivedMessages().count(), 1);
+    QCOMPARE(ptrTargets(server.receivedMessages().at(0)), QList<QByteArray>{Fqdn2});
+
+    // Wait for the multicast rate limit to pass
+    QTest::qWait(1000);
+    server.clearReceivedMessages();
+
+    // Known answers arriving in a packet following a truncated query must
+    // be taken into account
+    QMdnsEngine::Message truncatedMessage;
+    truncatedMessage.setAddress(QMdnsEngine::MdnsIpv4Address);
+    truncatedMessage.setPort(QMdnsEngine::MdnsPort);
+    truncatedMessage.setTruncated(true);
+    truncatedMessage.addQuery(query);
+    truncatedMessage.addRecord(staleRecord);
+    server.deliverMessage(truncatedMessage);
+    QMdnsEngine::Message continuationMessage;
+    continuationMessage.setAddress(QMdnsEngine::MdnsIpv4Address);
+    continuationMessage.setPort(QMdnsEngine::MdnsPort);
+    continuationMessage.addRecord(knownRecord);
+    server.deliverMessage(continuationMessage);
+    QTRY_COMPARE(server.receivedMessages().count(), 1);
+    QCOMPARE(ptrTargets(server.receivedMessages().at(0)), QList<QByteArray>{Fqdn2});
+}
+
+void TestProvider::testInterfaceReply()
+{
+    TestServer server;
+    QMdnsEngine::Hostname hostname(&server);
+    QMdnsEngine::Provider provider(&server, &hostname);
+
+    QMdnsEngine::Service service;
+    service.setName(Name);
+    service.setType(Type);
+    service.setPort(Port);
+    provider.update(service);
+
+    QMdnsEngine::Record record;
+    QTRY_VERIFY(server.cache()->lookupRecord(Fqdn, QMdnsEngine::SRV, record));
+    server.clearReceivedMessages();
+
+    // The same query arriving on two interfaces must be answered on each of
+    // them rather than merged or suppressed as a repeated multicast
+    QMdnsEngine::Query query;
+    query.setName(Type);
+    query.setType(QMdnsEngine::PTR);
+    QMdnsEngine::Message message;
+    message.setAddress(QMdnsEngine::MdnsIpv4Address);
+    message.setPort(QMdnsEngine::MdnsPort);
+    message.addQuery(query);
+    message.setInterfaceIndex(1);
+    server.deliverMessage(message);
+    message.setInterfaceIndex(2);
+    server.deliverMessage(message);
+    QTRY_COMPARE(server.receivedMessages().count(), 2);
+
+    QList<int> interfaceIndexes;
+    const auto replies = server.receivedMessages();
+    for (const QMdnsEngine::Message &reply : replies) {
+        QCOMPARE(ptrTargets(reply), QList<QByteArray>{Fqdn});
+        interfaceIndexes.append(reply.interfaceIndex());
+    }
+    std::sort(interfaceIndexes.begin(), interfaceIndexes.end());
+    QCOMPARE(interfaceIndexes, (QList<int>{1, 2}));
+}
+
+void TestProvider::testInterfacesChanged()
+{
+    TestServer server;
+    QMdnsEngine::Hostname hostname(&server);
+    QMdnsEngine::Provider provider(&server, &hostname);
+
+    QMdnsEngine::Service service;
+    service.setName(Name);
+    service.setType(Type);
+    service.setPort(Port);
+    provider.update(service);
+
+    QMdnsEngine::Record record;
+    QTRY_VERIFY(server.cache()->lookupRecord(Fqdn, QMdnsEngine::SRV, record));
+    server.clearReceivedMessages();
+
+    // A change to the interfaces must announce the records again
+    emit server.interfacesChanged();
+    bool announced = false;
+    const auto messages = server.receivedMessages();
+    for (const QMdnsEngine::Message &message : messages) {
+        const auto records = message.records();
+        for (const QMdnsEngine::Record &announcedRecord : records) {
+            if (message.isResponse() && announcedRecord.type() == QMdnsEngine::SRV &&
+                    announcedRecord.name() == Fqdn) {
+                announced = true;
+            }
+        }
+    }
+    QVERIFY(announced);
+}
+
+QList<QByteArray> TestProvider::ptrTargets(const QMdnsEngine::Message &message) const
+{
+    QList<QByteArray> targets;
+    const auto records = message.records();
+    for (const QMdnsEngine::Record &record : records) {
+        if (record.type() == QMdnsEngine::PTR) {
+            targets.append(record.target());
+        }
+    }
+    return targets;
+}
+
 QTEST_MAIN(TestProvider)
 #include "TestProvider.moc"
@@ -0,0 +1,242 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+#include <QtEndian>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+#include "common/replayserver.h"
+
+Q_DECLARE_METATYPE(QMdnsEngine::Message)
+
+const QByteArray Name = "Test.local.";
+const QHostAddress Ipv4Address("192.168.1.1");
+const QHostAddress Ipv6Address("fe80::1");
+
+class TestReplayServer : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void initTestCase();
+    void testPcap();
+    void testPcapng();
+
+private:
+
+    QByteArray mdnsPacket() const;
+    QByteArray udp(quint16 sourcePort, quint16 destinationPort, const QByteArray &payload) const;
+    QByteArray ipv4(const QByteArray &payload) const;
+    QByteArray ipv6(const QByteArray &payload) const;
+    QByteArray ethernet(quint16 etherType, const QByteArray &payload) const;
+
+    template<class T>
+    void append(QByteArray &data, T value) const;
+};
+
+void TestReplayServer::initTestCase()
+{
+    qRegisterMetaType<QMdnsEngine::Message>("Message");
+}
+
+void TestReplayServer::testPcap()
+{
+    // Create a capture with an mDNS response, an ARP frame and a datagram
+    // for another port
+    QByteArray capture;
+    append<quint32>(capture, 0xa1b2c3d4);
+    append<quint16>(capture, 2);
+    append<quint16>(capture, 4);
+    append<quint32>(capture, 0);
+    append<quint32>(capture, 0);
+    append<quint32>(capture, 65535);
+    append<quint32>(capture, 1);
+    const QList<QByteArray> frames{
+        ethernet(0x0800, ipv4(udp(QMdnsEngine::MdnsPort, QMdnsEngine::MdnsPort, mdnsPacket()))),
+        ethernet(0x0806, QByteArray(28, '\0')),
+        ethernet(0x0800, ipv4(udp(1234, 53, QByteArray(12, '\0'))))
+    };
+    for (const QByteArray &frame : frames) {
+        append<quint32>(capture, 1);
+        append<quint32>(capture, 0);
+        append<quint32>(capture, frame.length());
+        append<quint32>(capture, frame.length());
+        capture.append(frame);
+    }
+
+    QBuffer buffer(&capture);
+    buffer.open(QIODevice::ReadOnly);
+    ReplayServer server;
+    QVERIFY(server.load(&buffer));
+    QCOMPARE(server.packetCount(), 1);
+    QCOMPARE(server.skippedCount(), 2);
+
+    // Replaying as fast as possible delivers the message immediately
+    QSignalSpy messageReceivedSpy(&server, SIGNAL(messageReceived(Message)));
+    QSignalSpy finishedSpy(&server, SIGNAL(finished()));
+    server.replay(ReplayServer::AsFastAsPossible);
+    QCOMPARE(messageReceivedSpy.count(), 1);
+    QCOMPARE(finishedSpy.count(), 1);
+    QMdnsEngine::Message message = messageReceivedSpy.at(0).at(0).value<QMdnsEngine::Message>();
+    QCOMPARE(message.address(), Ipv4Address);
+    QCOMPARE(message.port(), QMdnsEngine::MdnsPort);
+    QCOMPARE(message.records().count(), 1);
+    QCOMPARE(message.records().at(0).name(), Name);
+}
+
+void TestReplayServer::testPcapng()
+{
+    // Create a capture with a section header, a raw IP interface with
+    // millisecond timestamps and two packets captured 200ms apart
+    QByteArray capture;
+    append<quint32>(capture, 0x0a0d0d0a);
+    append<quint32>(capture, 28);
+    append<quint32>(capture, 0x1a2b3c4d);
+    append<quint16>(capture, 1);
+    append<quint16>(capture, 0);
+    append<quint64>(capture, Q_UINT64_C(0xffffffffffffffff));
+    append<quint32>(capture, 28);
+    append<quint32>(capture, 1);
+    append<quint32>(capture, 32);
+    append<quint16>(capture, 101);
+    append<quint16>(capture, 0);
+    append<quint32>(capture, 65535);
+    append<quint16>(capture, 9);
+    append<quint16>(capture, 1);
+    capture.append(QByteArray("\x03\0\0\0", 4));
+    append<quint32>(capture, 0);
+    append<quint32>(capture, 32);
+    const QByteArray frame = ipv6(udp(QMdnsEngine::MdnsPort, QMdnsEngine::MdnsPort, mdnsPacket()));
+    const int padding = (4 - frame.length() % 4) % 4;
+    for (quint32 time : {1000u, 1200u}) {
+        append<quint32>(capture, 6);
+        append<quint32>(capture, 32 + frame.length() + padding);
+        append<quint32>(capture, 0);
+        append<quint32>(capture, 0);
+        append<quint32>(capture, time);
+        append<quint32>(capture, frame.length());
+        append<quint32>(capture, frame.length());
+        capture.append(frame);
+        capture.append(QByteArray(padding, '\0'));
+        append<quint32>(capture, 32 + frame.length() + padding);
+    }
+
+    QBuffer buffer(&capture);
+    buffer.open(QIODevice::ReadOnly);
+    ReplayServer server;
+    QVERIFY(server.load(&buffer));
+    QCOMPARE(server.packetCount(), 2);
+
+    // Replaying in recorded time must preserve the interval between them
+    QSignalSpy messageReceivedSpy(&server, SIGNAL(messageReceived(Message)));
+    QSignalSpy finishedSpy(&server, SIGNAL(finished()));
+    QElapsedTimer timer;
+    timer.start();
+    server.replay(ReplayServer::RecordedTime);
+    QCOMPARE(messageReceivedSpy.count(), 1);
+    QTRY_COMPARE(finishedSpy.count(), 1);
+    QVERIFY(timer.elapsed() >= 200);
+    QCOMPARE(messageReceivedSpy.count(), 2);
+    QCOMPARE(messageReceivedSpy.at(1).at(0).value<QMdnsEngine::Message>().address(), Ipv6Address);
+}
+
+QByteArray TestReplayServer::mdnsPacket() const
+{
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(QMdnsEngine::A);
+    record.setAddress(Ipv4Address);
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(record);
+    QByteArray packet;
+    QMdnsEngine::toPacket(message, packet);
+    return packet;
+}
+
+QByteArray TestReplayServer::udp(quint16 sourcePort, quint16 destinationPort, const QByteArray &payload) const
+{
+    QByteArray datagram;
+    append<quint16>(datagram, sourcePort);
+    append<quint16>(datagram, destinationPort);
+    append<quint16>(datagram, 8 + payload.length());
+    append<quint16>(datagram, 0);
+    return datagram + payload;
+}
+
+QByteArray TestReplayServer::ipv4(const QByteArray &payload) const
+{
+    QByteArray packet;
+    append<quint16>(packet, 0x4500);
+    append<quint16>(packet, 20 + payload.length());
+    append<quint32>(packet, 0);
+    append<quint16>(packet, 0xff11);
+    append<quint16>(packet, 0);
+    append<quint32>(packet, Ipv4Address.toIPv4Address());
+    append<quint32>(packet, QMdnsEngine::MdnsIpv4Address.toIPv4Address());
+    return packet + payload;
+}
+
+QByteArray TestReplayServer::ipv6(const QByteArray &payload) const
+{
+    QByteArray packet;
+    append<quint32>(packet, 0x60000000);
+    append<quint16>(packet, payload.length());
+    append<quint16>(packet, 0x11ff);
+    Q_IPV6ADDR sourceAddress = Ipv6Address.toIPv6Address();
+    packet.append(reinterpret_cast<const char*>(&sourceAddress), sizeof(Q_IPV6ADDR));
+    Q_IPV6ADDR destinationAddress = QMdnsEngine::MdnsIpv6Address.toIPv6Address();
+    packet.append(reinterpret_cast<const char*>(&destinationAddress), sizeof(Q_IPV6ADDR));
+    return packet + payload;
+}
+
+QByteArray TestReplayServer::ethernet(quint16 etherType, const QByteArray &payload) const
+{
+    QByteArray frame(12, '\0');
+    append<quint16>(frame, etherType);
+    return frame + payload;
+}
+
+template<class T>
+void TestReplayServer::append(QByteArray &data, T value) const
+{
+    // Both the capture and network headers are written in big endian byte
+    // order; the magic numbers in the capture indicate this to the reader
+    value = qToBigEndian<T>(value);
+    data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+QTEST_MAIN(TestReplayServer)
+#include "TestReplayServer.moc"
@@ -0,0 +1,173 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QHostAddress>
+#include <QObject>
+#include <QTest>
+#include <QUdpSocket>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/server.h>
+#include <qmdnsengine/statistics.h>
+
+const int Timeout = 2000;
+const int Count = 5;
+
+class TestSendQueue : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void initTestCase();
+    void testDelay();
+    void testBatch();
+    void testBatchDelay();
+    void testThreaded();
+
+private:
+
+    QMdnsEngine::Message message(int index) const;
+    int pendingCount();
+
+    QUdpSocket mReceiver;
+};
+
+void TestSendQueue::initTestCase()
+{
+    // The messages are sent by unicast to a socket on the loopback
+    // interface, which does not depend on multicast being available
+    QVERIFY(mReceiver.bind(QHostAddress(QHostAddress::LocalHost), 0));
+}
+
+void TestSendQueue::testDelay()
+{
+    QMdnsEngine::Server server;
+    QCOMPARE(server.sendBatchDelay(), 0);
+    server.setSendBatchDelay(-1);
+    QCOMPARE(server.sendBatchDelay(), 0);
+    server.setSendBatchDelay(5000);
+    QCOMPARE(server.sendBatchDelay(), 5000);
+}
+
+void TestSendQueue::testBatch()
+{
+    QMdnsEngine::Server server;
+    server.setHistogramsEnabled(true);
+
+    // Messages sent in the same pass through the event loop are queued and
+    // sent together once control returns to it
+    for (int i = 0; i < Count; ++i) {
+        server.sendMessage(message(i));
+    }
+    QCOMPARE(server.statistics().counter(QMdnsEngine::Statistics::SendFlushes), 0ULL);
+
+    int received = 0;
+    QTRY_VERIFY_WITH_TIMEOUT((received += pendingCount()) == Count, Timeout);
+    QMdnsEngine::Statistics statistics = server.statistics();
+    QCOMPARE(statistics.counter(QMdnsEngine::Statistics::SendFlushes), 1ULL);
+    QCOMPARE(statistics.counter(QMdnsEngine::Statistics::PacketsSent), static_cast<quint64>(Count));
+
+    // Five packets fall into the bucket for values from 4 to 7
+    QVector<quint64> buckets = statistics.histogram(QMdnsEngine::Statistics::PacketsPerFlush);
+    QCOMPARE(buckets.at(3), 1ULL);
+}
+
+void TestSendQueue::testBatchDelay()
+{
+    QMdnsEngine::Server server;
+    server.setHistogramsEnabled(true);
+    server.setSendBatchDelay(500000);
+
+    // With a delay, messages sent in separate passes share a batch
+    server.sendMessage(message(0));
+    QTest::qWait(50);
+    server.sendMessage(message(1));
+    QTest::qWait(50);
+    QCOMPARE(server.statistics().counter(QMdnsEngine::Statistics::SendFlushes), 0ULL);
+    QCOMPARE(pendingCount(), 0);
+
+    int received = 0;
+    QTRY_VERIFY_WITH_TIMEOUT((received += pendingCount()) == 2, Timeout);
+    QMdnsEngine::Statistics statistics = server.statistics();
+    QCOMPARE(statistics.counter(QMdnsEngine::Statistics::SendFlushes), 1ULL);
+    QVector<quint64> buckets = statistics.histogram(QMdnsEngine::Statistics::PacketsPerFlush);
+    QCOMPARE(buckets.at(2), 1ULL);
+}
+
+void TestSendQueue::testThreaded()
+{
+    QMdnsEngine::Server server;
+    server.setIoThreadEnabled(true);
+    QVERIFY(server.isIoThreadEnabled());
+
+    // Messages are queued for the I/O thread and sent from there
+    server.sendMessage(message(0));
+    int received = 0;
+    QTRY_VERIFY_WITH_TIMEOUT((received += pendingCount()) == 1, Timeout);
+
+    // Messages still queued for the thread when it stops are not lost
+    for (int i = 0; i < Count; ++i) {
+        server.sendMessage(message(i));
+    }
+    server.setIoThreadEnabled(false);
+    QVERIFY(!server.isIoThreadEnabled());
+    received = 0;
+    QTRY_VERIFY_WITH_TIMEOUT((received += pendingCount()) == Count, Timeout);
+
+    // Neither are packets held back by the batch delay
+    server.setSendBatchDelay(5000000);
+    server.sendMessage(message(0));
+    server.setIoThreadEnabled(true);
+    received = 0;
+    QTRY_VERIFY_WITH_TIMEOUT((received += pendingCount()) == 1, Timeout);
+}
+
+QMdnsEngine::Message TestSendQueue::message(int index) const
+{
+    QMdnsEngine::Query query;
+    query.setName("test-" + QByteArray::number(index) + ".local.");
+    query.setType(QMdnsEngine::A);
+    QMdnsEngine::Message message;
+    message.setAddress(QHostAddress::LocalHost);
+    message.setPort(mReceiver.localPort());
+    message.addQuery(query);
+    return message;
+}
+
+int TestSendQueue::pendingCount()
+{
+    // Read (and discard) every datagram that has arrived
+    int count = 0;
+    while (mReceiver.hasPendingDatagrams()) {
+        mReceiver.readDatagram(nullptr, 0);
+        ++count;
+    }
+    return count;
+}
+
+QTEST_MAIN(TestSendQueue)
+#include "TestSendQueue.moc"
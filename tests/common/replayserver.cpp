@@ -0,0 +1,477 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QFile>
+#include <QIODevice>
+#include <QtEndian>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+
+#include "replayserver.h"
+
+// Magic numbers identifying the format and byte order of the capture
+const quint32 PcapMagic = 0xa1b2c3d4;
+const quint32 PcapNsecMagic = 0xa1b23c4d;
+const quint32 PcapngSectionHeader = 0x0a0d0d0a;
+const quint32 PcapngByteOrderMagic = 0x1a2b3c4d;
+
+// pcapng block types
+const quint32 PcapngInterfaceDescription = 1;
+const quint32 PcapngObsoletePacket = 2;
+const quint32 PcapngSimplePacket = 3;
+const quint32 PcapngEnhancedPacket = 6;
+
+// pcapng option holding the timestamp resolution of an interface
+const quint16 PcapngTsresolOption = 9;
+
+// Link types (see https://www.tcpdump.org/linktypes.html)
+const quint16 LinkTypeNull = 0;
+const quint16 LinkTypeEthernet = 1;
+const quint16 LinkTypeRaw = 101;
+const quint16 LinkTypeLinuxSll = 113;
+const quint16 LinkTypeIpv4 = 228;
+const quint16 LinkTypeIpv6 = 229;
+const quint16 LinkTypeLinuxSll2 = 276;
+
+const quint16 EtherTypeIpv4 = 0x0800;
+const quint16 EtherTypeIpv6 = 0x86dd;
+const quint16 EtherTypeVlan = 0x8100;
+const quint16 EtherTypeQinQ = 0x88a8;
+
+const quint8 ProtocolUdp = 17;
+
+// Link type and timestamp resolution of an interface in a pcapng capture
+struct PcapngInterface
+{
+    quint16 linkType;
+    quint8 tsresol;
+};
+
+template<class T>
+static T readInteger(const char *data, bool bigEndian)
+{
+    const uchar *src = reinterpret_cast<const uchar*>(data);
+    return bigEndian ? qFromBigEndian<T>(src) : qFromLittleEndian<T>(src);
+}
+
+ReplayServer::ReplayServer(QObject *parent)
+    : AbstractServer(parent),
+      mSkippedCount(0),
+      mInvalidCount(0),
+      mSentCount(0),
+      mSpeed(1),
+      mNext(0)
+{
+    connect(&mTimer, &QTimer::timeout, this, &ReplayServer::onTimeout);
+
+    mTimer.setSingleShot(true);
+    mTimer.setTimerType(Qt::PreciseTimer);
+}
+
+bool ReplayServer::load(const QString &filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        mErrorString = file.errorString();
+        return false;
+    }
+    return load(&file);
+}
+
+bool ReplayServer::load(QIODevice *device)
+{
+    mPackets.clear();
+    mSkippedCount = 0;
+    mInvalidCount = 0;
+
+    // The whole capture is read into memory before it is decoded
+    const QByteArray capture = device->readAll();
+    if (capture.length() < 4) {
+        mErrorString = "capture is too short";
+        return false;
+    }
+    const quint32 magic = readInteger<quint32>(capture.constData(), false);
+    if (magic == PcapngSectionHeader) {
+        return loadPcapng(capture);
+    }
+    return loadPcap(capture);
+}
+
+QString ReplayServer::errorString() const
+{
+    return mErrorString;
+}
+
+int ReplayServer::packetCount() const
+{
+    return mPackets.count();
+}
+
+int ReplayServer::skippedCount() const
+{
+    return mSkippedCount;
+}
+
+int ReplayServer::invalidCount() const
+{
+    return mInvalidCount;
+}
+
+int ReplayServer::sentCount() const
+{
+    return mSentCount;
+}
+
+void ReplayServer::setSpeed(double speed)
+{
+    if (speed > 0) {
+        mSpeed = speed;
+    }
+}
+
+void ReplayServer::replay(Timing timing)
+{
+    mTimer.stop();
+    mInvalidCount = 0;
+    mNext = 0;
+
+    if (timing == AsFastAsPossible) {
+        for (const Packet &packet : qAsConst(mPackets)) {
+            deliver(packet);
+        }
+        mNext = mPackets.count();
+        emit finished();
+        return;
+    }
+
+    mClock.start();
+    onTimeout();
+}
+
+bool ReplayServer::isReplaying() const
+{
+    return mTimer.isActive();
+}
+
+void ReplayServer::sendMessage(const QMdnsEngine::Message &)
+{
+    ++mSentCount;
+}
+
+void ReplayServer::sendMessageToAll(const QMdnsEngine::Message &)
+{
+    ++mSentCount;
+}
+
+void ReplayServer::onTimeout()
+{
+    // Deliver every message that is due, measuring time from the first
+    // message in the capture
+    const qint64 elapsed = static_cast<qint64>(mClock.nsecsElapsed() * mSpeed);
+    while (mNext < mPackets.count() &&
+            mPackets.at(mNext).time - mPackets.at(0).time <= elapsed) {
+        deliver(mPackets.at(mNext++));
+    }
+    if (mNext == mPackets.count()) {
+        emit finished();
+        return;
+    }
+    scheduleNext();
+}
+
+bool ReplayServer::loadPcap(const QByteArray &capture)
+{
+    if (capture.length() < 24) {
+        mErrorString = "capture is too short";
+        return false;
+    }
+
+    // The magic number indicates both byte order and timestamp resolution
+    const char *data = capture.constData();
+    bool bigEndian;
+    qint64 fractionScale;
+    const quint32 magic = readInteger<quint32>(data, false);
+    if (magic == PcapMagic || magic == PcapNsecMagic) {
+        bigEndian = false;
+    } else if (qbswap(magic) == PcapMagic || qbswap(magic) == PcapNsecMagic) {
+        bigEndian = true;
+    } else {
+        mErrorString = "unrecognized capture format";
+        return false;
+    }
+    fractionScale = readInteger<quint32>(data, bigEndian) == PcapNsecMagic ? 1 : 1000;
+    const quint16 linkType = readInteger<quint32>(data + 20, bigEndian) & 0xffff;
+
+    int offset = 24;
+    while (offset + 16 <= capture.length()) {
+        const qint64 seconds = readInteger<quint32>(data + offset, bigEndian);
+        const qint64 fraction = readInteger<quint32>(data + offset + 4, bigEndian);
+        const quint32 length = readInteger<quint32>(data + offset + 8, bigEndian);
+        offset += 16;
+        if (length > static_cast<quint32>(capture.length() - offset)) {
+            mErrorString = "capture is truncated";
+            return false;
+        }
+        addFrame(linkType, seconds * 1000000000 + fraction * fractionScale, data + offset, length);
+        offset += length;
+    }
+    return true;
+}
+
+bool ReplayServer::loadPcapng(const QByteArray &capture)
+{
+    // Each section begins with a header indicating its byte order and is
+    // followed by descriptions of the interfaces that packets refer to
+    QVector<PcapngInterface> interfaces;
+    bool bigEndian = false;
+    qint64 lastTime = 0;
+
+    const char *data = capture.constData();
+    int offset = 0;
+    while (offset + 12 <= capture.length()) {
+        const char *block = data + offset;
+        quint32 type = readInteger<quint32>(block, bigEndian);
+        if (type == PcapngSectionHeader) {
+            const quint32 byteOrderMagic = readInteger<quint32>(block + 8, false);
+            if (byteOrderMagic == PcapngByteOrderMagic) {
+                bigEndian = false;
+            } else if (qbswap(byteOrderMagic) == PcapngByteOrderMagic) {
+                bigEndian = true;
+            } else {
+                mErrorString = "unrecognized capture format";
+                return false;
+            }
+            interfaces.clear();
+        }
+        const quint32 length = readInteger<quint32>(block + 4, bigEndian);
+        if (length < 12 || length % 4 || length > static_cast<quint32>(capture.length() - offset)) {
+            mErrorString = "capture is truncated";
+            return false;
+        }
+        offset += length;
+
+        // The body lies between the type and length at the beginning and the
+        // repeated length at the end of the block
+        const char *body = block + 8;
+        const int bodyLength = length - 12;
+        switch (type) {
+        case PcapngInterfaceDescription:
+        {
+            if (bodyLength < 8) {
+                break;
+            }
+            PcapngInterface description{readInteger<quint16>(body, bigEndian), 6};
+            for (int i = 8; i + 4 <= bodyLength;) {
+                const quint16 code = readInteger<quint16>(body + i, bigEndian);
+                const quint16 optionLength = readInteger<quint16>(body + i + 2, bigEndian);
+                if (!code || i + 4 + optionLength > bodyLength) {
+                    break;
+                }
+                if (code == PcapngTsresolOption && optionLength == 1) {
+                    description.tsresol = static_cast<quint8>(body[i + 4]);
+                }
+                i += 4 + ((optionLength + 3) & ~3);
+            }
+            interfaces.append(description);
+            break;
+        }
+        case PcapngEnhancedPacket:
+        case PcapngObsoletePacket:
+        {
+            if (bodyLength < 20) {
+                break;
+            }
+            const quint32 id = type == PcapngEnhancedPacket ?
+                    readInteger<quint32>(body, bigEndian) : readInteger<quint16>(body, bigEndian);
+            const quint64 timestamp = (static_cast<quint64>(readInteger<quint32>(body + 4, bigEndian)) << 32) |
+                    readInteger<quint32>(body + 8, bigEndian);
+            const quint32 captured = readInteger<quint32>(body + 12, bigEndian);
+            if (id >= static_cast<quint32>(interfaces.count()) || captured > static_cast<quint32>(bodyLength - 20)) {
+                ++mSkippedCount;
+                break;
+            }
+
+            // The resolution is either a negative power of 10 or (if the
+            // most significant bit is set) a negative power of 2
+            const quint8 tsresol = interfaces.at(id).tsresol;
+            qint64 time;
+            if (tsresol & 0x80) {
+                const int shift = tsresol & 0x7f;
+                time = static_cast<qint64>((timestamp >> shift) * 1000000000 +
+                        (((timestamp & ((Q_UINT64_C(1) << shift) - 1)) * 1000000000) >> shift));
+            } else {
+                time = static_cast<qint64>(timestamp);
+                for (int i = tsresol; i < 9; ++i) {
+                    time *= 10;
+                }
+                for (int i = 9; i < tsresol; ++i) {
+                    time /= 10;
+                }
+            }
+            lastTime = time;
+            addFrame(interfaces.at(id).linkType, time, body + 20, captured);
+            break;
+        }
+        case PcapngSimplePacket:
+        {
+            // Simple packets have no timestamp and always belong to the
+            // first interface
+            if (bodyLength < 4 || interfaces.isEmpty()) {
+                break;
+            }
+            const int captured = qMin<quint32>(readInteger<quint32>(body, bigEndian), bodyLength - 4);
+            addFrame(interfaces.at(0).linkType, lastTime, body + 4, captured);
+            break;
+        }
+        }
+    }
+    return true;
+}
+
+void ReplayServer::addFrame(quint16 linkType, qint64 time, const char *data, int length)
+{
+    // Find the network layer protocol and strip the link layer header
+    quint16 etherType = 0;
+    int offset = 0;
+    switch (linkType) {
+    case LinkTypeEthernet:
+        offset = 14;
+        if (length >= offset) {
+            etherType = readInteger<quint16>(data + 12, true);
+            while ((etherType == EtherTypeVlan || etherType == EtherTypeQinQ) && length >= offset + 4) {
+                etherType = readInteger<quint16>(data + offset + 2, true);
+                offset += 4;
+            }
+        }
+        break;
+    case LinkTypeLinuxSll:
+        offset = 16;
+        if (length >= offset) {
+            etherType = readInteger<quint16>(data + 14, true);
+        }
+        break;
+    case LinkTypeLinuxSll2:
+        offset = 20;
+        if (length >= offset) {
+            etherType = readInteger<quint16>(data, true);
+        }
+        break;
+    case LinkTypeNull:
+        offset = 4;
+        break;
+    case LinkTypeRaw:
+    case LinkTypeIpv4:
+    case LinkTypeIpv6:
+        break;
+    default:
+        ++mSkippedCount;
+        return;
+    }
+    if (length < offset + 1 || (etherType && etherType != EtherTypeIpv4 && etherType != EtherTypeIpv6)) {
+        ++mSkippedCount;
+        return;
+    }
+    data += offset;
+    length -= offset;
+
+    // Find the transport layer protocol and the source address, skipping
+    // fragmented datagrams and any IPv6 extension headers
+    QHostAddress address;
+    quint8 protocol;
+    int headerLength;
+    switch (static_cast<quint8>(data[0]) >> 4) {
+    case 4:
+    {
+        headerLength = (data[0] & 0x0f) * 4;
+        if (length < 20 || headerLength < 20 || length < headerLength ||
+                readInteger<quint16>(data + 6, true) & 0x3fff) {
+            ++mSkippedCount;
+            return;
+        }
+        length = qMin<int>(length, readInteger<quint16>(data + 2, true));
+        protocol = static_cast<quint8>(data[9]);
+        address = QHostAddress(readInteger<quint32>(data + 12, true));
+        break;
+    }
+    case 6:
+    {
+        if (length < 40) {
+            ++mSkippedCount;
+            return;
+        }
+        length = qMin<int>(length, 40 + readInteger<quint16>(data + 4, true));
+        protocol = static_cast<quint8>(data[6]);
+        address = QHostAddress(reinterpret_cast<const quint8*>(data + 8));
+        headerLength = 40;
+        while ((protocol == 0 || protocol == 43 || protocol == 60) && length >= headerLength + 8) {
+            protocol = static_cast<quint8>(data[headerLength]);
+            headerLength += (static_cast<quint8>(data[headerLength + 1]) + 1) * 8;
+        }
+        break;
+    }
+    default:
+        ++mSkippedCount;
+        return;
+    }
+    if (protocol != ProtocolUdp || length < headerLength + 8) {
+        ++mSkippedCount;
+        return;
+    }
+    data += headerLength;
+    length -= headerLength;
+
+    // Only datagrams to or from the mDNS port are replayed
+    const quint16 sourcePort = readInteger<quint16>(data, true);
+    const quint16 destinationPort = readInteger<quint16>(data + 2, true);
+    if (sourcePort != QMdnsEngine::MdnsPort && destinationPort != QMdnsEngine::MdnsPort) {
+        ++mSkippedCount;
+        return;
+    }
+    length = qMin<int>(length, readInteger<quint16>(data + 4, true));
+    if (length < 8) {
+        ++mSkippedCount;
+        return;
+    }
+    mPackets.append({time, address, sourcePort, QByteArray(data + 8, length - 8)});
+}
+
+void ReplayServer::deliver(const Packet &packet)
+{
+    QMdnsEngine::Message message;
+    if (!QMdnsEngine::fromPacket(packet.data, message)) {
+        ++mInvalidCount;
+        return;
+    }
+    message.setAddress(packet.address);
+    message.setPort(packet.port);
+    emit messageReceived(message);
+}
+
+void ReplayServer::scheduleNext()
+{
+    const qint64 due = mPackets.at(mNext).time - mPackets.at(0).time;
+    const qint64 remaining = static_cast<qint64>((due - mClock.nsecsElapsed() * mSpeed) / mSpeed);
+    mTimer.start(static_cast<int>(qMax<qint64>(0, (remaining + 999999) / 1000000)));
+}
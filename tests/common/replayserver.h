@@ -0,0 +1,169 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef COMMON_REPLAYSERVER_H
+#define COMMON_REPLAYSERVER_H
+
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/message.h>
+
+class QIODevice;
+
+/**
+ * @brief Server that replays mDNS traffic from a packet capture
+ *
+ * Captures in either the pcap or pcapng format can be loaded. Each UDP
+ * datagram sent to or from port 5353 (over IPv4 or IPv6) in the capture is
+ * decoded when it is replayed and emitted with the messageReceived() signal,
+ * as if it were received by a server on the network. Messages sent to the
+ * server are counted and discarded.
+ *
+ * Supported link types are Ethernet (with or without VLAN tags), Linux
+ * cooked captures (v1 and v2), BSD loopback and raw IP. Fragmented IP
+ * datagrams are skipped.
+ */
+class ReplayServer : public QMdnsEngine::AbstractServer
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * @brief Timing used to replay the messages
+     */
+    enum Timing {
+        /// Deliver all of the messages at once
+        AsFastAsPossible,
+        /// Deliver the messages at the times they were captured
+        RecordedTime
+    };
+
+    explicit ReplayServer(QObject *parent = 0);
+
+    /**
+     * @brief Load a capture from the specified file
+     */
+    bool load(const QString &filename);
+
+    /**
+     * @brief Load a capture from the specified device
+     */
+    bool load(QIODevice *device);
+
+    /**
+     * @brief Retrieve a description of the last error that occurred
+     */
+    QString errorString() const;
+
+    /**
+     * @brief Retrieve the number of mDNS datagrams loaded
+     */
+    int packetCount() const;
+
+    /**
+     * @brief Retrieve the number of frames that did not contain an mDNS datagram
+     */
+    int skippedCount() const;
+
+    /**
+     * @brief Retrieve the number of datagrams that could not be decoded
+     */
+    int invalidCount() const;
+
+    /**
+     * @brief Retrieve the number of messages sent to the server
+     */
+    int sentCount() const;
+
+    /**
+     * @brief Set the speed at which recorded time passes
+     *
+     * A speed of 2 replays the capture in half the time it took to record;
+     * the speed must be greater than zero.
+     */
+    void setSpeed(double speed);
+
+    /**
+     * @brief Begin replaying the loaded messages
+     *
+     * When replaying as fast as possible, all of the messages are delivered
+     * before this method returns. The finished() signal is emitted once the
+     * last message is delivered.
+     */
+    void replay(Timing timing);
+
+    /**
+     * @brief Determine if the messages are being replayed in recorded time
+     */
+    bool isReplaying() const;
+
+    virtual void sendMessage(const QMdnsEngine::Message &message);
+    virtual void sendMessageToAll(const QMdnsEngine::Message &message);
+
+Q_SIGNALS:
+
+    /**
+     * @brief Indicate that all of the messages have been delivered
+     */
+    void finished();
+
+private Q_SLOTS:
+
+    void onTimeout();
+
+private:
+
+    struct Packet
+    {
+        qint64 time;
+        QHostAddress address;
+        quint16 port;
+        QByteArray data;
+    };
+
+    bool loadPcap(const QByteArray &capture);
+    bool loadPcapng(const QByteArray &capture);
+    void addFrame(quint16 linkType, qint64 time, const char *data, int length);
+    void deliver(const Packet &packet);
+    void scheduleNext();
+
+    QVector<Packet> mPackets;
+    QString mErrorString;
+    int mSkippedCount;
+    int mInvalidCount;
+    int mSentCount;
+
+    double mSpeed;
+    int mNext;
+    QTimer mTimer;
+    QElapsedTimer mClock;
+};
+
+#endif // COMMON_REPLAYSERVER_H